@@ -0,0 +1,34 @@
+#ifndef AISCHEDULER_H
+#define AISCHEDULER_H
+
+#include <QPointF>
+#include "EntityStore.h"
+
+class Level;
+
+// Spreads the expensive part of enemy AI over frames. Today that is
+// perception (the line of sight to the player that behaviour scripts read
+// with `sees`); scripts themselves stay cheap and run every tick on
+// whatever was last perceived.
+//
+// Living enemies are served round-robin in slot order, as many per tick as
+// it takes to get around all of them within MAX_STALE_TICKS, so what a
+// script sees is never older than that. The schedule depends only on the
+// enemies, not on how fast the machine is, so recordings replay exactly.
+class AiScheduler {
+public:
+    AiScheduler();
+    
+    void run(EntityStore& store, const Level& level, const QPointF& target);
+    
+    // Enemies served by the last run
+    int lastServed() const { return m_lastServed; }
+    
+    static constexpr int MAX_STALE_TICKS = 6;   // Oldest perception a script can see (100 ms)
+
+private:
+    int m_cursor;        // Slot the next run starts from
+    int m_lastServed;
+};
+
+#endif // AISCHEDULER_H
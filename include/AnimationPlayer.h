@@ -0,0 +1,42 @@
+#ifndef ANIMATIONPLAYER_H
+#define ANIMATIONPLAYER_H
+
+#include <QRect>
+#include "SpriteSheet.h"
+
+// How a state animates: which sheet, how fast and whether it loops.
+// Clip tables are static and shared by every character of the same kind.
+struct AnimationClip {
+    const SpriteSheet* sheet;
+    float frameRate;
+    bool loop;
+};
+
+// Per-instance playback state. Plain data, so any number of entities can
+// play the same sheet independently for a few bytes each.
+struct AnimationPlayer {
+    const SpriteSheet* sheet;
+    float frameTime;
+    float elapsedTime;
+    int currentFrame;
+    bool playing;
+    bool loop;
+    bool finished;
+    
+    // Switch to a clip and play it from the first frame
+    void start(const AnimationClip& clip);
+    
+    // Advance playback (call each frame)
+    void update(float deltaTime);
+    
+    QRect currentFrameRect() const { return sheet->frameRect(currentFrame); }
+    
+    void play();
+    void pause() { playing = false; }
+    void reset();
+    
+    bool isLoaded() const { return sheet != nullptr; }
+    bool isFinished() const { return finished; }
+};
+
+#endif // ANIMATIONPLAYER_H
@@ -0,0 +1,83 @@
+#ifndef BEHAVIOURVM_H
+#define BEHAVIOURVM_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "EnemySystem.h"
+
+// Tiny register machine for enemy behaviour. Scripts are plain text from the
+// level data, one instruction per line, assembled once when the level loads
+// into a shared flat code array; each enemy keeps only its program, program
+// counter, wait timer and eight float registers (BehaviourComponent).
+//
+//     start:
+//         dist r0                 # r0 = distance to the player
+//         jump_less r0 160 hunt
+//         patrol
+//         jump start
+//     hunt:
+//         face_player
+//         chase 45                # pixels per second
+//
+// Movement instructions (patrol, chase, flee, idle, wait) end the enemy's
+// turn for this tick, as does a throw that goes off. Running off the end of
+// a script starts it over. At most STEP_LIMIT instructions
+// run per enemy per tick, so a script that never moves still has a bounded
+// cost. Nothing is allocated while scripts run.
+//
+// Instructions (r = register r0..r7, v = number, l = label defined once per script):
+//     set r v, add r v          registers
+//     dist r                    distance to the player
+//     sees r                    1 if the player was in sight when the AiScheduler last looked, else 0
+//     jump l, jump_less r v l, jump_greater r v l
+//     face_player, patrol, chase v, flee v, idle, wait v, throw
+class BehaviourVm {
+public:
+    enum class Op : quint8 {
+        SET,
+        ADD,
+        DIST,
+        SEES,
+        JUMP,
+        JUMP_LESS,
+        JUMP_GREATER,
+        FACE_PLAYER,
+        PATROL,
+        CHASE,
+        FLEE,
+        IDLE,
+        WAIT,
+        THROW
+    };
+    
+    struct Instruction {
+        Op op;
+        quint8 reg;
+        qint16 target;    // Jump destination, relative to the program start
+        float value;
+    };
+    
+    static constexpr int STEP_LIMIT = 16;
+    
+    // Assemble a script and return its program id, or -1 if it does not
+    // assemble (the error is logged). The same text loads only once.
+    int load(const QString& source);
+    void clear();
+    int programCount() const { return m_programs.size(); }
+    
+    // Run one tick of an enemy's script
+    void execute(EntityStore& store, Entity enemy, const EnemySystem::Context& context) const;
+
+private:
+    struct Program {
+        int start;
+        int length;
+    };
+    
+    QVector<Instruction> m_code;
+    QVector<Program> m_programs;
+    QHash<QString, int> m_loaded;   // Source text -> program id
+};
+
+#endif // BEHAVIOURVM_H
@@ -0,0 +1,28 @@
+#ifndef BLITKERNELS_H
+#define BLITKERNELS_H
+
+#include <QtGlobal>
+
+// Span kernels for premultiplied ARGB32 pixels. One implementation per
+// instruction set; select() picks the best one the CPU supports at runtime.
+namespace BlitKernels {
+
+struct Kernels {
+    // dst[i] = color
+    void (*fill)(quint32* dst, int count, quint32 color);
+    // dst[i] = src[i] over dst[i]
+    void (*blend)(quint32* dst, const quint32* src, int count);
+    // dst[i] = src[count - 1 - i] over dst[i] (horizontal flip)
+    void (*blendFlipped)(quint32* dst, const quint32* src, int count);
+    const char* name;
+};
+
+// Best kernels for this CPU. DEATHRIDDLE_BLIT_KERNEL=scalar|sse2|avx2
+// forces a specific one (falling back if unsupported).
+const Kernels& select();
+
+const Kernels& scalar();
+
+}
+
+#endif // BLITKERNELS_H
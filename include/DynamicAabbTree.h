@@ -0,0 +1,83 @@
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QVarLengthArray>
+#include <QVector>
+
+// Bounding volume hierarchy over moving boxes. Leaves hold "fat" boxes,
+// enlarged by a margin and by the direction of travel, so a collider that
+// moves a little stays inside its leaf and costs nothing; only when it
+// leaves the fat box is it removed and reinserted, with the tree kept
+// balanced by rotations on the way back up. Queries visit O(log n) nodes.
+class DynamicAabbTree {
+public:
+    static constexpr int NULL_NODE = -1;
+    static constexpr float MARGIN = 4.0f;               // Pixels of slack around every leaf
+    static constexpr float DISPLACEMENT_MULTIPLIER = 4.0f;  // Frames of motion predicted
+    
+    DynamicAabbTree();
+    
+    int createProxy(const QRectF& box, int userData);
+    void destroyProxy(int proxy);
+    
+    // Returns true if the proxy had to be reinserted
+    bool moveProxy(int proxy, const QRectF& box, const QPointF& displacement);
+    
+    int userData(int proxy) const { return m_nodes[proxy].userData; }
+    const QRectF& fatBox(int proxy) const { return m_nodes[proxy].box; }
+    int height() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].height; }
+    void clear();
+    
+    // Calls f(proxy) for every leaf whose fat box overlaps box
+    template<typename F>
+    void query(const QRectF& box, F f) const {
+        QVarLengthArray<int, 64> stack;
+        if (m_root != NULL_NODE) stack.append(m_root);
+        while (!stack.isEmpty()) {
+            int index = stack.last();
+            stack.removeLast();
+            const Node& node = m_nodes[index];
+            if (!overlaps(node.box, box)) continue;
+            if (node.isLeaf()) {
+                f(index);
+            } else {
+                stack.append(node.child1);
+                stack.append(node.child2);
+            }
+        }
+    }
+
+private:
+    struct Node {
+        QRectF box;
+        int userData;
+        int parent;      // Next free node while on the free list
+        int child1;
+        int child2;
+        int height;      // Leaves are 0, free nodes -1
+        
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+    
+    // Edges touching counts as overlap, unlike QRectF::intersects
+    static bool overlaps(const QRectF& a, const QRectF& b) {
+        return a.left() <= b.right() && b.left() <= a.right()
+            && a.top() <= b.bottom() && b.top() <= a.bottom();
+    }
+    static float perimeter(const QRectF& box) { return 2.0f * static_cast<float>(box.width() + box.height()); }
+    
+    int allocateNode();
+    void freeNode(int index);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refitAncestors(int index);
+    int balance(int index);
+    
+    QVector<Node> m_nodes;
+    int m_root;
+    int m_freeList;
+};
+
+#endif // DYNAMICAABBTREE_H
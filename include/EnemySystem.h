@@ -0,0 +1,138 @@
+#ifndef ENEMYSYSTEM_H
+#define ENEMYSYSTEM_H
+
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#include <QString>
+#include <QVector>
+
+class BehaviourVm;
+class Level;
+class ProjectileSystem;
+
+// Enemy mechanics over the ENEMY entities of a store: spawning, the hurt,
+// throwing and death states, and the moves behaviour scripts are made of
+// (patrol, walk, throw). What each enemy does with them is decided by its
+// script in the BehaviourVm. Walking stops at walls and ledges through
+// Level's tile queries.
+//
+// Update cost follows the camera: enemies near the viewport run every tick;
+// further out they are DORMANT (animation frozen) and run only every
+// REDUCED_INTERVAL ticks, staggered, with the time they missed; beyond
+// that they sleep. Waking enemies catch up on the time owed (up to
+// MAX_CATCH_UP) in reduced-rate steps; a throw clip started during the
+// catch-up is played through those steps too. An enemy playing its hurt or
+// throw clip stays active until the clip ends, wherever it is.
+//
+// An enemy's update only touches its own components, so update() runs
+// ranges of UPDATE_GRAIN slots as separate jobs. Throws are buffered per
+// range and spawned once all ranges are done, in slot order, so the
+// projectiles come out the same whichever thread ran which enemy. The job
+// graph and the buffers belong to the EnemySystem and are reused from tick
+// to tick; everything else is static and works on the store passed in.
+class EnemySystem {
+public:
+    // A throw made during update, spawned after every enemy has run
+    struct Launch {
+        QPointF origin;
+        QPointF velocity;
+    };
+    
+    // What scripts see of the world during one update
+    struct Context {
+        const Level& level;
+        QPointF target;       // Centre of the player
+        float deltaTime;
+        QRectF viewport;      // What the camera shows
+        int tick;             // Staggers reduced-rate updates
+        QVector<Launch>* launches = nullptr;   // Set by update() per job
+    };
+    
+    // program: BehaviourVm program id, -1 for the built-in patrol
+    static Entity spawn(EntityStore& store, EnemyType type, const QPointF& position, int riddleId = -1, int program = -1);
+    
+    // Run every living enemy's script for one tick at each enemy's level
+    // of detail, then spawn their throws into projectiles. Runs on the
+    // calling thread when all slots fit in one range.
+    void update(EntityStore& store, const BehaviourVm& behaviours, const Context& context,
+                ProjectileSystem& projectiles, JobSystem& jobs);
+    
+    // Script used when the level gives an enemy none
+    static QString defaultBehaviour(EnemyType type);
+    
+    // Moves. patrol walks back and forth around the spawn point, turning at
+    // walls, ledges and the end of the route; walk moves dx pixels unless a
+    // wall or ledge is in the way (returns false if it stopped); tryThrow
+    // throws at target if the throw cooldown allows, adding to launches.
+    static void patrol(EntityStore& store, Entity enemy, const Level& level, float deltaTime);
+    static bool walk(EntityStore& store, Entity enemy, const Level& level, float dx);
+    static bool tryThrow(EntityStore& store, Entity enemy, const QPointF& target, QVector<Launch>& launches);
+    
+    // Refresh what the enemy knows about target (line of sight); called
+    // by the AiScheduler, at least every AiScheduler::MAX_STALE_TICKS
+    static void perceive(EntityStore& store, Entity enemy, const Level& level, const QPointF& target);
+    
+    static void setState(EntityStore& store, Entity enemy, EnemyState state);
+    static void takeDamage(EntityStore& store, Entity enemy);
+    static void die(EntityStore& store, Entity enemy);
+    static bool isDead(const EntityStore& store, Entity enemy) { return store.enemy(enemy).state == EnemyState::DEAD; }
+    static bool isDeathAnimationFinished(const EntityStore& store, Entity enemy);
+    
+    // Destroy enemies whose death animation has ended
+    static void releaseFinished(EntityStore& store);
+    // Destroy every enemy (level change)
+    static void clear(EntityStore& store);
+    
+    // Size constants
+    static constexpr float WIDTH = 32.0f;
+    static constexpr float HEIGHT = 32.0f;
+    static constexpr float PATROL_DISTANCE = 64.0f;
+    static constexpr float PATROL_SPEED = 30.0f;
+    static constexpr float LEDGE_PROBE = 4.0f;   // Depth checked for ground ahead
+    static constexpr float THROW_INTERVAL = 2.5f;
+    static constexpr float THROW_SPEED = 260.0f;
+    
+    // Level of detail by distance outside the viewport
+    static constexpr float ACTIVE_MARGIN = 64.0f;
+    static constexpr float REDUCED_MARGIN = 960.0f;
+    static constexpr int REDUCED_INTERVAL = 4;             // Ticks between reduced-rate updates
+    static constexpr float MAX_STEP = REDUCED_INTERVAL / 60.0f;  // Longest single catch-up step
+    static constexpr float MAX_CATCH_UP = 2.0f;            // Seconds simulated on waking
+    
+    static constexpr int UPDATE_GRAIN = 64;   // Slots per update job
+
+private:
+    enum class Detail {
+        ACTIVE,
+        REDUCED,
+        ASLEEP
+    };
+    static Detail detailFor(const QRectF& box, const QRectF& viewport);
+    // update() for the enemies in slots [begin, end)
+    static void updateSlots(EntityStore& store, const BehaviourVm& behaviours, const Context& context, int begin, int end);
+    // Hurt or throw clip still running (the script waits for it)
+    static bool isPlayingReaction(const EntityStore& store, Entity enemy);
+    // One script step of deltaTime, once hurt and throw animations are over
+    static void think(EntityStore& store, Entity enemy, const BehaviourVm& behaviours, const Context& context);
+    
+    // Shared per-type clip for a state
+    static const AnimationClip& clipFor(EnemyType type, EnemyState state);
+    static void throwAt(EntityStore& store, Entity enemy, const QPointF& target, QVector<Launch>& launches);
+    
+    // Range job of the graph, and the final spawn of the first rangeCount buffers
+    void runRange(int range);
+    void spawnLaunches(ProjectileSystem& projectiles, int rangeCount);
+    
+    // What the graph's jobs work on, set by update() for its duration
+    EntityStore* m_store = nullptr;
+    const BehaviourVm* m_behaviours = nullptr;
+    const Context* m_context = nullptr;
+    ProjectileSystem* m_projectiles = nullptr;
+    
+    JobSystem::Graph m_graph;        // Rebuilt only when the range count changes
+    int m_rangeCount = 0;
+    QVector<QVector<Launch>> m_launches;   // One buffer per range, emptied every tick
+};
+
+#endif // ENEMYSYSTEM_H
@@ -0,0 +1,194 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector>
+#include "AnimationPlayer.h"
+#include "DynamicAabbTree.h"
+#include "JobSystem.h"
+
+// Handle to an entity in an EntityStore. Handles carry the generation of
+// their slot, so one kept past destroy() is recognised as stale instead of
+// silently pointing at whatever reused the slot.
+struct Entity {
+    int index = -1;
+    quint32 generation = 0;
+    
+    bool isNull() const { return index < 0; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+enum class EnemyType {
+    PINK_MONSTER,
+    OWLET_MONSTER
+};
+
+enum class EnemyState {
+    IDLE,
+    WALKING,
+    HURT,
+    DEAD,
+    THROWING
+};
+
+// Enemy-only data: behaviour state, riddle link and patrol route
+struct EnemyComponent {
+    EnemyType type;
+    EnemyState state;
+    int riddleId;
+    bool riddleTriggered;   // Prevents re-triggering the riddle
+    QPointF patrolOrigin;
+    float patrolDistance;
+    float patrolSpeed;
+    float throwCooldown;    // Seconds until the next throw
+    float pendingTime;      // Simulation time owed while ticked at a reduced rate or asleep
+};
+
+// Script state of an entity run by the BehaviourVm: which program, where in
+// it, a pending wait and the script's registers, plus what the AiScheduler
+// last perceived for it
+struct BehaviourComponent {
+    static constexpr int REGISTER_COUNT = 8;
+    
+    int program = -1;       // -1 runs the built-in patrol
+    int pc = 0;
+    float wait = 0.0f;      // Seconds left of a wait instruction
+    float registers[REGISTER_COUNT] = {};
+    bool seesTarget = false;
+};
+
+// Kinematic platform following a closed path of waypoints (top-left
+// positions); with two waypoints it shuttles back and forth
+struct PlatformComponent {
+    QVector<QPointF> waypoints;
+    int target;         // Waypoint currently heading for
+    float speed;        // Pixels per second
+    QPointF delta;      // Movement during the last update, handed to riders
+};
+
+// Every game object (the player and all enemies) as an entity id with its
+// components in contiguous per-component arrays indexed by the id, so a
+// system touches only the arrays it needs and walks them front to back.
+// A mask per slot says which components an entity has; destroyed slots are
+// recycled through a free list, so steady-state play never allocates.
+//
+// Entities with a COLLIDER component are also kept in a dynamic AABB tree
+// (refitted by syncColliders()), so finding what overlaps a box does not
+// scan every entity.
+//
+// Plain data with no signals: game code reads and writes the components
+// directly, and only the UI-facing Player2D facade turns changes into
+// Qt signals.
+class EntityStore {
+public:
+    enum Component : quint32 {
+        TRANSFORM = 1 << 0,   // Position and velocity
+        BODY = 1 << 1,        // Collision size
+        SPRITE = 1 << 2,      // Animation playback and facing
+        ENEMY = 1 << 3,
+        PLATFORM = 1 << 4,
+        COLLIDER = 1 << 5,    // Indexed in the collider tree
+        BEHAVIOUR = 1 << 6,   // Driven by a behaviour script
+        DORMANT = 1 << 7      // Tag: far from the camera, animation frozen
+    };
+    
+    explicit EntityStore(int capacity = DEFAULT_CAPACITY);
+    
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+    
+    Entity create(quint32 components);
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+    bool has(Entity entity, quint32 components) const;
+    // For tags that come and go during play (DORMANT); an entity must keep
+    // at least one component
+    void addComponents(Entity entity, quint32 components) { m_masks[entity.index] |= components; }
+    void removeComponents(Entity entity, quint32 components) { m_masks[entity.index] &= ~components; }
+    int count() const { return m_count; }
+    
+    // Calls f(entity) for every live entity that has all of components
+    template<typename F>
+    void forEach(quint32 components, F f) const {
+        forEachInSlots(components, 0, m_masks.size(), f);
+    }
+    
+    // Same over slots [begin, end) only, so a pass can be split into jobs
+    template<typename F>
+    void forEachInSlots(quint32 components, int begin, int end, F f) const {
+        for (int index = begin; index < end; ++index) {
+            if ((m_masks[index] & components) == components && m_masks[index] != 0) {
+                f(Entity{ index, m_generations[index] });
+            }
+        }
+    }
+    int slotCount() const { return m_masks.size(); }
+    
+    // Component access; the entity must be alive and have the component
+    QPointF& position(Entity entity) { return m_positions[entity.index]; }
+    QPointF position(Entity entity) const { return m_positions[entity.index]; }
+    QPointF& velocity(Entity entity) { return m_velocities[entity.index]; }
+    QPointF velocity(Entity entity) const { return m_velocities[entity.index]; }
+    QSizeF& size(Entity entity) { return m_sizes[entity.index]; }
+    QRectF boundingBox(Entity entity) const { return QRectF(m_positions[entity.index], m_sizes[entity.index]); }
+    AnimationPlayer& animation(Entity entity) { return m_animations[entity.index]; }
+    const AnimationPlayer& animation(Entity entity) const { return m_animations[entity.index]; }
+    bool isFacingRight(Entity entity) const { return m_facingRight[entity.index] != 0; }
+    void setFacingRight(Entity entity, bool facingRight) { m_facingRight[entity.index] = facingRight ? 1 : 0; }
+    EnemyComponent& enemy(Entity entity) { return m_enemies[entity.index]; }
+    const EnemyComponent& enemy(Entity entity) const { return m_enemies[entity.index]; }
+    PlatformComponent& platform(Entity entity) { return m_platforms[entity.index]; }
+    const PlatformComponent& platform(Entity entity) const { return m_platforms[entity.index]; }
+    BehaviourComponent& behaviour(Entity entity) { return m_behaviours[entity.index]; }
+    const BehaviourComponent& behaviour(Entity entity) const { return m_behaviours[entity.index]; }
+    
+    // Animation system: advances every sprite that is not DORMANT by
+    // deltaTime, in slot ranges spread over jobs
+    void updateAnimations(float deltaTime, JobSystem& jobs);
+    static constexpr int ANIMATION_GRAIN = 256;   // Slots per job
+    
+    // Bring the collider tree up to date with the colliders' current boxes.
+    // Colliders that stayed inside their fat box cost one containment test.
+    void syncColliders();
+    
+    // Calls f(entity) for every collider whose box may overlap box (as of
+    // the last syncColliders(); callers test the exact bounding box)
+    template<typename F>
+    void queryColliders(const QRectF& box, F f) const {
+        m_colliders.query(box, [this, &f](int proxy) {
+            int index = m_colliders.userData(proxy);
+            f(Entity{ index, m_generations[index] });
+        });
+    }
+    const DynamicAabbTree& colliderTree() const { return m_colliders; }
+    
+    static constexpr int DEFAULT_CAPACITY = 256;
+
+private:
+    QVector<quint32> m_masks;        // 0 marks a free slot
+    QVector<quint32> m_generations;
+    QVector<int> m_freeSlots;
+    int m_count;
+    
+    // Components, one entry per slot
+    QVector<QPointF> m_positions;
+    QVector<QPointF> m_velocities;
+    QVector<QSizeF> m_sizes;
+    QVector<AnimationPlayer> m_animations;
+    QVector<quint8> m_facingRight;
+    QVector<EnemyComponent> m_enemies;
+    QVector<PlatformComponent> m_platforms;
+    QVector<BehaviourComponent> m_behaviours;
+    
+    // Collider tree proxy and the position it was last synced at
+    QVector<int> m_proxies;
+    QVector<QPointF> m_syncedPositions;
+    DynamicAabbTree m_colliders;
+    
+    JobSystem::ParallelFor m_animationJobs;   // Reused by every updateAnimations
+};
+
+#endif // ENTITYSTORE_H
@@ -0,0 +1,59 @@
+#ifndef FIELDOFVIEW_H
+#define FIELDOFVIEW_H
+
+#include <QImage>
+#include <QPoint>
+#include <QVector>
+
+class Level;
+
+// Tile-grid field of view with fog of war, for the maze level. Visibility is
+// recomputed with recursive shadowcasting only when the viewer moves to a new
+// cell, and only the cells that changed are touched. Cells seen once stay
+// explored for the rest of the level.
+//
+// The fog is kept as a mask image with one pixel per tile (opaque black for
+// unexplored, dimmed for explored, clear for visible), ready to be drawn
+// scaled up by Level::TILE_SIZE.
+class FieldOfView {
+public:
+    FieldOfView();
+    
+    // Forget everything and size the grid for a level (0x0 disables the fog)
+    void reset(int width, int height);
+    bool isEnabled() const { return m_width > 0; }
+    
+    // Recompute from the viewer's cell; returns false if the cell is unchanged
+    bool update(const Level& level, const QPoint& cell, int radius);
+    
+    bool isVisible(int x, int y) const { return cellState(x, y) == VISIBLE; }
+    bool isExplored(int x, int y) const { return cellState(x, y) != UNEXPLORED; }
+    
+    const QImage& fogMask() const { return m_fogMask; }
+    
+    // Mask colours, premultiplied
+    static constexpr QRgb UNEXPLORED_FOG = 0xFF000000;
+    static constexpr QRgb EXPLORED_FOG = 0xB0000000;
+
+private:
+    enum CellState : quint8 {
+        UNEXPLORED,
+        EXPLORED,
+        VISIBLE
+    };
+    
+    CellState cellState(int x, int y) const;
+    void setCell(int x, int y, CellState state);
+    void markVisible(int x, int y);
+    void castLight(const Level& level, int row, float startSlope, float endSlope,
+                   int radius, int xx, int xy, int yx, int yy);
+    
+    int m_width;
+    int m_height;
+    QPoint m_origin;
+    QVector<quint8> m_cells;        // CellState per tile, row-major
+    QVector<int> m_visibleCells;    // Indices currently VISIBLE
+    QImage m_fogMask;
+};
+
+#endif // FIELDOFVIEW_H
@@ -4,24 +4,61 @@
 #include "Player2D.h"
 #include "Level.h"
 #include "Riddle.h"
+#include "LevelLoader.h"
+#include "LevelChunkCache.h"
+#include "SpriteBatch.h"
+#include "SoftwareRenderer.h"
+#include "ParticleSystem.h"
+#include "ProjectileSystem.h"
+#include "FieldOfView.h"
+#include "LightMap.h"
+#include "EntityStore.h"
+#include "EnemySystem.h"
+#include "BehaviourVm.h"
+#include "AiScheduler.h"
+#include "JobSystem.h"
+#include "Replay.h"
+#include "TripleBuffer.h"
 #include <QWidget>
 #include <QTimer>
 #include <QElapsedTimer>
 #include <QLabel>
 #include <QSet>
+#include <QHash>
 #include <QKeyEvent>
+#include <QThread>
+#include <functional>
 
 class GameWidget : public QWidget {
     Q_OBJECT
 
 public:
     explicit GameWidget(QWidget* parent = nullptr);
-    virtual ~GameWidget() = default;
+    virtual ~GameWidget();
     
+    // Start a new game. Interactive play steps the world on a thread of its
+    // own from here on; this widget only forwards input, shows dialogs and
+    // paints the frames the simulation publishes.
     void startGame();
-    void pauseGame();
-    void resumeGame();
-    void resetGame();
+    
+    // Headless playback of a recorded run: startReplay() resets the game,
+    // then every stepReplay() advances one fixed tick (returning false once
+    // the recorded session has ended) and renderScene() draws the frame.
+    void startReplay(const QVector<ReplayEvent>& events, int levelNumber = 1);
+    bool stepReplay();
+    const QImage& renderScene();
+    
+    // Wait for background rasterization so the next frame is steady-state
+    void finishBackgroundWork();
+    
+    // Time spent in each part of the last renderScene()
+    struct PaintTimings {
+        qint64 levelNs = 0;     // drawLevel, or chunks, tiles and platforms in software
+        qint64 spritesNs = 0;   // Player, enemies, projectiles and particles (batch flush included)
+        qint64 overlaysNs = 0;  // Lighting, fog, UI, transition and end screens
+        qint64 totalNs = 0;
+    };
+    const PaintTimings& lastPaintTimings() const { return m_paintTimings; }
 
 signals:
     void returnToMainMenu();
@@ -33,41 +70,141 @@ protected:
     void timerEvent(QTimerEvent* event) override;
 
 private slots:
-    void update();
     void onRiddleSolved(bool success);
 
 private:
+    // Simulation thread; with nothing running there yet (or during
+    // playback) these run on the calling thread
+    void tick();
+    void resetGame();
+    void pauseGame();
+    void resumeGame();
+    
+    // Run task on the simulation thread or the GUI thread: at once when
+    // already there, otherwise queued
+    void simulate(std::function<void()> task);
+    void onGuiThread(std::function<void()> task);
+    
     void setupGame();
     void loadLevel(int levelNumber);
+    void beginLevelTransition(int nextLevelNumber);
+    void updateTransition(float deltaTime);
     void updatePhysics(float deltaTime);
     void checkCollisions();
     void checkTileInteractions();
     void handleInput();
+    void step(float deltaTime);
+    void handleKeyPress(int key, bool autoRepeat);
+    void showMessage(bool warning, const QString& title, const QString& text);
+    void setLabelText(QLabel* label, const QString& text);
     
-    // Rendering
-    void drawLevel(QPainter& painter);
-    void drawPlayer(QPainter& painter);
-    void drawEnemies(QPainter& painter);
-    void drawVictoryScreen(QPainter& painter);
-    void drawEnemy(QPainter& painter, class Enemy* enemy);
+    // Rendering; everything drawn comes from a FrameSnapshot
+    struct FrameSnapshot;
+    void publishFrame();
+    void drawLevel(QPainter& painter, const FrameSnapshot& frame);
+    void drawPlatforms(QPainter& painter, const FrameSnapshot& frame);
+    void drawSprites(QPainter& painter, const FrameSnapshot& frame);
+    void drawVictoryScreen(QPainter& painter, const FrameSnapshot& frame);
     void drawUI(QPainter& painter);
-    void drawTile(QPainter& painter, const Tile* tile);
-    void drawRetryScreen(QPainter& painter);
+    void drawParticles(const FrameSnapshot& frame);   // Queues sprite kinds into the batch
+    void drawParticleRects(QPainter& painter, const FrameSnapshot& frame);
+    void drawFog(QPainter& painter, const FrameSnapshot& frame);
+    void drawLighting(QPainter& painter, const FrameSnapshot& frame);
+    QPoint playerCell() const;
+    bool isInSight(const QRectF& box) const;
+    void updateParticles(float deltaTime);
+    void updateProjectiles(float deltaTime);
+    void drawProjectiles(const FrameSnapshot& frame);
+    static void drawTile(QPainter& painter, const Tile* tile);  // Also runs on chunk workers
+    void drawRetryScreen(QPainter& painter, const FrameSnapshot& frame);
+    void drawTransition(QPainter& painter, const FrameSnapshot& frame);
+    // Pre-rendered chunk, if it was captured from the level in frame
+    const QImage* levelChunk(const FrameSnapshot& frame, int index) const;
+    void drawLevelCompleteText(QPainter& painter, const FrameSnapshot& frame);
+    void drawLevelTitleText(QPainter& painter, const FrameSnapshot& frame);
+    void presentScene(const QImage& scene);
+    QRect sceneRect() const { return QRect(0, 0, LOGICAL_WIDTH, LOGICAL_HEIGHT); }
+    // Left edge of the camera, centred on the player within the level
+    int cameraLeft() const;
+    
+    // Software renderer path (DEATHRIDDLE_RENDERER=software). Records the
+    // level and sprite paint times in m_paintTimings as it goes.
+    void renderSoftware(const FrameSnapshot& frame, const QElapsedTimer& sectionTimer);
+    const QImage* tileImage(const Tile* tile);
     
     // Riddle system
-    void showRiddle(int riddleId, class Enemy* enemy);
+    void showRiddle(int riddleId, Entity enemy);
+    void answerRiddle(bool ok, const QString& answer);
     void hideRiddle();
     void checkEnemyCollisions();
     
-    // Game state
+    // Game state. Once the simulation thread runs, the world (entities,
+    // level, systems, replay, input and progress) belongs to it; the GUI
+    // thread sees it only through m_frames.
+    JobSystem m_jobs;        // Worker threads for simulation and chunk painting
+    QThread m_simulationThread;
+    QObject* m_simulation;   // Lives on m_simulationThread; parent of levels, loader and timer
+    bool m_headless;         // Playback stepped by the caller, no simulation thread
+    EntityStore m_entities;  // The player and the current level's enemies
     Player2D* m_player;
     Level* m_currentLevel;
+    LevelLoader* m_levelLoader;
+    LevelChunkCache* m_chunkCache;   // GUI thread
+    int m_levelSerial;               // Bumped on every level load
     QVector<Riddle*> m_riddles;
     Riddle* m_activeRiddle;
-    class Enemy* m_activeEnemy;
+    Entity m_activeEnemy;
+    BehaviourVm m_behaviours;   // The current level's enemy scripts
+    EnemySystem m_enemies;      // Enemy update jobs and their throw buffers
+    AiScheduler m_aiScheduler;  // Enemy perception, round-robin over ticks
+    ParticleSystem m_particles;
+    ProjectileSystem m_projectiles;
+    FieldOfView m_fieldOfView;  // Enabled in the maze
+    LightMap m_lightMap;        // Enabled on dark levels
+    float m_runDustTimer;
+    
+    // Recording (DEATHRIDDLE_RECORD) and headless playback
+    enum class ReplayMode {
+        NONE,
+        RECORDING,
+        PLAYING
+    };
+    ReplayMode m_replayMode;
+    Replay m_recording;
+    QVector<ReplayEvent> m_playback;
+    int m_tick;             // Simulation steps since the run started
+    int m_playbackCursor;   // Next input event to apply
+    int m_playbackEnd;      // Tick the recorded session ended on
+    int m_openMessages;     // Message boxes the world waits for
+    float m_respawnDelay;   // Seconds until respawn after losing a life
+    
+    // Rendering
+    SpriteBatch m_spriteBatch;
+    QImage m_sceneBuffer;  // Logical-resolution target for the QPainter path
+    PaintTimings m_paintTimings;
+    SoftwareRenderer m_softwareRenderer;
+    bool m_useSoftwareRenderer;
+    QHash<int, QImage> m_tileImages;  // Pre-rendered tiles by type and state
+    QVector<QRectF> m_particleRects;  // Reused each frame for square particles
+    QImage m_exploredFogTile;  // Software path: one tile of explored fog
+    QVector<QImage> m_shadeTiles;  // Software path: one tile per light level
+    
+    // Full-scene overlay rendered once and reused until what it shows changes
+    struct OverlayLayer {
+        QImage image;
+        int levelNumber = -1;
+        int score = -1;
+        int highestScore = -1;
+    };
+    void drawOverlay(QPainter& painter, OverlayLayer& layer, const FrameSnapshot& frame,
+                     void (GameWidget::*paint)(QPainter&, const FrameSnapshot&));
+    OverlayLayer m_retryOverlay;
+    OverlayLayer m_victoryOverlay;
+    OverlayLayer m_levelCompleteOverlay;
+    OverlayLayer m_levelTitleOverlay;
     
     // Timing
-    QTimer* m_gameTimer;
+    QTimer* m_gameTimer;    // Steps the world on the simulation thread
     QElapsedTimer m_elapsedTimer;
     float m_lastFrameTime;
     
@@ -78,6 +215,62 @@ private:
     bool m_showRetryScreen;
     bool m_showVictoryScreen;
     
+    // Level transition (fade out, swap in prefetched level, fade in)
+    enum class TransitionPhase {
+        NONE,
+        FADE_OUT,
+        FADE_IN
+    };
+    TransitionPhase m_transitionPhase;
+    float m_transitionTime;
+    int m_nextLevelNumber;
+    
+    // What the renderer sees of the world: the simulation thread copies it
+    // at the end of every tick and hands it to the GUI thread through a
+    // triple buffer, so drawing never reads live game state and neither
+    // thread ever waits for the other
+    struct SpriteInstance {
+        const SpriteSheet* sheet;   // nullptr draws the box in fallbackColor
+        int frame;
+        QRectF box;                 // Sprite drawn at its top-left
+        bool facingRight;
+        QRgb fallbackColor;
+    };
+    struct ParticleInstances {
+        QVector<QPointF> centres;
+        QVector<int> frames;        // Sprite kinds only
+        QVector<quint8> flipped;
+    };
+    struct FrameSnapshot {
+        int tick = -1;                   // -1 until the first publish
+        bool hasLevel = false;
+        int levelSerial = 0;             // Which load of the level, for the chunk cache
+        int cameraX = 0;
+        int levelNumber = 0;
+        QString levelName;
+        int levelColumns = 0;
+        int levelRows = 0;
+        int firstColumn = 0;             // Visible tile columns
+        int lastColumn = -1;
+        QVector<Tile> tiles;             // Non-empty tiles of the visible columns
+        QVector<QRectF> platforms;
+        QVector<SpriteInstance> sprites; // Visible enemies, then the player
+        QVector<QPointF> projectiles;    // Centres
+        ParticleInstances particles[ParticleSystem::KIND_COUNT];
+        bool lit = false;
+        QImage shadeMask;
+        QVector<quint8> shade;           // Software path: light per tile
+        bool fogged = false;
+        QImage fogMask;
+        int score = 0;
+        int highestScore = 0;
+        TransitionPhase transitionPhase = TransitionPhase::NONE;
+        float transitionTime = 0.0f;
+        bool showRetryScreen = false;
+        bool showVictoryScreen = false;
+    };
+    TripleBuffer<FrameSnapshot> m_frames;
+    
     // Score tracking
     int m_highestScore;
     
@@ -95,6 +288,17 @@ private:
     // Constants
     static constexpr int TARGET_FPS = 60;
     static constexpr float FIXED_TIMESTEP = 1.0f / 60.0f;
+    static constexpr float TRANSITION_DURATION = 0.6f;  // Seconds per fade
+    static constexpr float RUN_DUST_INTERVAL = 0.2f;    // Seconds between run puffs
+    static constexpr float RUN_DUST_SPEED = 120.0f;     // Minimum speed for run dust
+    static constexpr int FOV_RADIUS = 7;                // Maze sight range in tiles
+    static constexpr float THROW_SPEED = 420.0f;        // Player rock launch speed
+    static constexpr int PROJECTILE_DAMAGE = 10;        // Health an enemy rock takes
+    static constexpr float RESPAWN_DELAY = 1.0f;        // Seconds before respawning
+    
+    // Fixed resolution the scene is rendered at before integer upscaling
+    static constexpr int LOGICAL_WIDTH = 960;
+    static constexpr int LOGICAL_HEIGHT = 640;
 };
 
 #endif // GAMEWIDGET_H
@@ -0,0 +1,60 @@
+#ifndef GOLDENFRAMES_H
+#define GOLDENFRAMES_H
+
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include "GameWidget.h"
+
+// Rendering regression check: plays every level offscreen without input,
+// renders it at a few fixed ticks and compares the frames against stored
+// golden images ("level3_tick90.png"). Small differences from antialiasing
+// or font hinting are tolerated; anything larger fails and leaves the
+// actual frame and a diff image next to the golden one.
+//
+// Each checked frame is also rendered several times to time drawLevel, the
+// sprites and the overlays. The timings are only reported unless budget
+// checking is asked for: wall-clock time depends on the machine and its
+// load, so it would make the pixel check flaky.
+class GoldenFrames {
+public:
+    enum class Mode {
+        CHECK,
+        UPDATE      // Overwrite the golden images with the current frames
+    };
+    
+    // With checkBudgets, a section slower than its budget times budgetScale
+    // fails the frame
+    GoldenFrames(Mode mode, const QString& directory, bool checkBudgets, double budgetScale);
+    
+    // Returns the number of failed checks, or -1 on error
+    int run();
+    // Golden frames that did not exist yet (not counted as failures)
+    int missingCount() const { return m_missing; }
+
+private:
+    bool checkFrame(const QString& name, const QImage& frame);
+    bool checkTimings(const QString& name, GameWidget& game);
+    
+    // Pixels where any channel differs by more than CHANNEL_TOLERANCE,
+    // marked red on a faded copy of the expected frame in diff
+    static int countDifferingPixels(const QImage& expected, const QImage& actual, QImage& diff);
+    
+    static constexpr int LEVEL_COUNT = 6;
+    static constexpr int CHANNEL_TOLERANCE = 8;
+    static constexpr double MAX_DIFFERING_FRACTION = 0.001;
+    
+    // Median of this many renders is compared to the budgets
+    static constexpr int TIMING_RUNS = 9;
+    static constexpr qint64 LEVEL_BUDGET_NS = 2000000;
+    static constexpr qint64 SPRITES_BUDGET_NS = 2000000;
+    static constexpr qint64 OVERLAYS_BUDGET_NS = 3000000;
+    
+    Mode m_mode;
+    QString m_directory;
+    bool m_checkBudgets;
+    double m_budgetScale;
+    int m_missing;
+};
+
+#endif // GOLDENFRAMES_H
@@ -0,0 +1,162 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+
+// Work-stealing thread pool. Every worker owns a deque: jobs it queues go
+// on the back and it takes its own work from the back (most recently queued,
+// still warm in cache); a worker with nothing left steals from the front of
+// another's deque. Threads that are not workers (the simulation thread)
+// queue into a shared deque and help run jobs while they wait, so nothing
+// blocks on an idle core.
+//
+// Work is described as a Graph: jobs plus "runs after" edges. A job is
+// queued the moment its last dependency finishes. Jobs must not depend on
+// the order they run in; systems that produce results (enemy throws) give
+// each job its own output and merge them in a fixed order afterwards, so a
+// run is identical whatever the thread count.
+//
+// Background jobs (submit) wait in a queue of their own. Workers pick them
+// up when no graph work is left, but a thread waiting in run() only helps
+// with graph jobs, so a tick never stops to paint a level chunk.
+//
+// DEATHRIDDLE_JOB_THREADS sets the worker count (default: one per core,
+// less the calling thread; 0 runs graphs on the calling thread and keeps a
+// single thread for background jobs).
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+    
+    class Graph {
+    public:
+        Graph() = default;
+        Graph(const Graph&) = delete;
+        Graph& operator=(const Graph&) = delete;
+        
+        // Returns the job's id. It runs after every job in dependencies,
+        // which must already be in the graph.
+        int add(Job job, std::initializer_list<int> dependencies = {});
+        int add(Job job, const QVector<int>& dependencies);
+        int size() const { return m_nodes.size(); }
+        void clear() { m_nodes.clear(); }
+    
+    private:
+        friend class JobSystem;
+        
+        struct Node {
+            Job job;
+            QVector<int> successors;
+            int dependencyCount = 0;
+            QAtomicInt waitingOn;   // Dependencies not finished in this run
+        };
+        QVector<Node> m_nodes;
+        QAtomicInt m_unfinished;
+        bool m_detached = false;           // Owned by the system (submit)
+        QAtomicInt* m_counter = nullptr;   // Released when a detached graph ends
+    };
+    
+    // workerCount -1 takes DEATHRIDDLE_JOB_THREADS or the core count
+    explicit JobSystem(int workerCount = -1);
+    ~JobSystem();
+    
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    
+    // Threads that run graph jobs besides the caller
+    int workerCount() const { return m_graphWorkers; }
+    
+    // Run every job of graph and return once all have finished. The graph
+    // can be run again.
+    void run(Graph& graph);
+    
+    // Splits [0, count) into ranges of at most grain and calls f(begin, end)
+    // for each, in parallel, returning when all are done. The graph of range
+    // jobs is kept while count and grain stay the same, so a loop run every
+    // tick allocates nothing. One per call site; a call must not nest in
+    // another on the same object.
+    class ParallelFor {
+    public:
+        ParallelFor() = default;
+        ParallelFor(const ParallelFor&) = delete;
+        ParallelFor& operator=(const ParallelFor&) = delete;
+        
+        template<typename F>
+        void run(JobSystem& jobs, int count, int grain, F f) {
+            if (count <= 0) return;
+            // A single range, or nobody to share the ranges with
+            if (count <= grain || jobs.workerCount() == 0) {
+                f(0, count);
+                return;
+            }
+            if (count != m_count || grain != m_grain) {
+                m_graph.clear();
+                for (int begin = 0; begin < count; begin += grain) {
+                    int end = std::min(count, begin + grain);
+                    m_graph.add([this, begin, end]() { m_call(m_function, begin, end); });
+                }
+                m_count = count;
+                m_grain = grain;
+            }
+            m_function = &f;
+            m_call = [](void* function, int begin, int end) { (*static_cast<F*>(function))(begin, end); };
+            jobs.run(m_graph);
+        }
+    
+    private:
+        Graph m_graph;
+        int m_count = 0;
+        int m_grain = 0;
+        // This call's f, reached through a plain function pointer so the
+        // jobs built for an earlier call can run it
+        void* m_function = nullptr;
+        void (*m_call)(void*, int, int) = nullptr;
+    };
+    
+    // Fire and forget: the job runs in the background, never on a thread
+    // waiting in run(). counter, if given, is raised now and lowered when
+    // the job has finished, for wait().
+    void submit(Job job, QAtomicInt* counter = nullptr);
+    
+    // Help run background jobs until counter drops to zero
+    void wait(const QAtomicInt& counter);
+
+private:
+    struct Task {
+        Graph* graph;
+        int node;
+    };
+    struct Queue {
+        QMutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    void workerLoop(int index);
+    void backgroundLoop();
+    void push(const Task& task);
+    // Own queue from the back, then steal from the front of the others
+    bool takeGraph(int self, Task& task);
+    bool takeBackground(Task& task);
+    void execute(const Task& task);
+    int ownQueue() const;
+    void sleep(bool graphWork);
+    
+    QVector<QThread*> m_workers;
+    int m_graphWorkers;
+    QVector<Queue*> m_queues;      // One per worker, then the shared one
+    Queue m_background;
+    QAtomicInt m_queuedGraph;
+    QAtomicInt m_queuedBackground;
+    QMutex m_sleepMutex;           // Idle threads wait on m_wake under it
+    QWaitCondition m_wake;
+    QAtomicInt m_quitting;
+};
+
+#endif // JOBSYSTEM_H
@@ -6,8 +6,9 @@
 #include <QPoint>
 #include <QRectF>
 #include <QString>
-
-class Enemy;
+#include <QtAlgorithms>
+#include "EntityStore.h"
+#include "LevelArena.h"
 
 enum class TileType {
     EMPTY,
@@ -18,19 +19,51 @@ enum class TileType {
     RIDDLE_TRIGGER,  // Triggers riddle challenge
     GOAL,            // Level end
     MOVING_PLATFORM,
-    BREAKABLE,
-    KEY              // Key to unlock goal
+    BREAKABLE,       // Crumbles when landed on, breaks when hit from below
+    KEY,             // Key to unlock goal
+    TORCH            // Wall torch, lights up dark levels
 };
 
 struct Tile {
     TileType type;
     QPoint gridPos;
     QRectF boundingBox;
-    bool collected;  // For coins
-    bool activated;  // For checkpoints/triggers
+    bool collected;  // For coins; broken breakables
+    bool activated;  // For checkpoints/triggers; crumbling breakables
+    bool respawns;   // Breakable that grows back after breaking
     int riddleId;    // Which riddle this triggers
     
-    Tile() : type(TileType::EMPTY), collected(false), activated(false), riddleId(-1) {}
+    Tile() : type(TileType::EMPTY), collected(false), activated(false), respawns(false), riddleId(-1) {}
+    
+    // Blocks movement (a crumbling breakable still holds until it breaks)
+    bool isSolid() const {
+        return type == TileType::SOLID || type == TileType::MOVING_PLATFORM
+            || (type == TileType::BREAKABLE && !collected);
+    }
+};
+
+// Where an enemy starts; the live enemies are entities created from these
+// when the level is entered
+struct EnemySpawn {
+    EnemyType type;
+    QPointF position;
+    int riddleId;
+    const char* behaviour;   // BehaviourVm script, nullptr for the type's default
+};
+
+// First contact of a ray or a moving box with the solid tiles
+struct TraceHit {
+    float fraction;   // Share of the ray or sweep travelled before contact, 0..1
+    QPointF position; // Ray: contact point; sweep: top-left of the box at contact
+    QPoint cell;      // Solid tile that was hit
+    QPoint normal;    // Face that was hit, pointing back against the motion
+};
+
+// Moving platform: starting box and the waypoints its top-left cycles through
+struct PlatformSpawn {
+    QRectF box;
+    QVector<QPointF> waypoints;
+    float speed;
 };
 
 class Level : public QObject {
@@ -41,9 +74,10 @@ public:
     
     // Level info
     int levelNumber() const { return m_levelNumber; }
-    QString name() const { return m_name; }
-    QString description() const { return m_description; }
+    QString name() const { return QString::fromUtf8(m_name); }
+    QString description() const { return QString::fromUtf8(m_description); }
     QPointF spawnPoint() const { return m_spawnPoint; }
+    bool isDark() const { return m_dark; }  // Lit only by light sources
     
     // Tile system
     static constexpr int TILE_SIZE = 32;
@@ -57,10 +91,45 @@ public:
     QVector<Tile*> getTilesInArea(const QRectF& area);
     QVector<Tile*> getSolidTiles();
     
+    // Tile classes, each kept as one bitboard per row (bit x of a row is
+    // column x). Solid follows breakables breaking and growing back; the
+    // other classes go by tile type, so callers still check a tile's state.
+    enum TileClass : quint8 {
+        SOLID_TILES = 1 << 0,
+        HAZARD_TILES = 1 << 1,        // Spikes
+        COLLECTIBLE_TILES = 1 << 2,   // Coins and keys
+        TRIGGER_TILES = 1 << 3        // Checkpoints, riddle triggers, goals
+    };
+    static constexpr int TILE_CLASS_COUNT = 4;
+    
     // Collision detection
-    bool isSolid(int gridX, int gridY) const;
+    bool isSolid(int gridX, int gridY) const {
+        if (gridX < 0 || gridX >= m_width || gridY < 0 || gridY >= m_height) {
+            return false;
+        }
+        return (rowBits(0, gridY)[gridX >> 6] >> (gridX & 63)) & 1;
+    }
     bool checkCollision(const QRectF& box, TileType& hitType);
     
+    // Area tests over the bitboards: a few mask ANDs per row. Areas are in
+    // pixels; touching a tile's edge does not count and outside the grid is
+    // empty. classes is a combination of TileClass flags.
+    bool anyInArea(const QRectF& area, quint8 classes) const;
+    bool isAreaSolid(const QRectF& area) const { return anyInArea(area, SOLID_TILES); }
+    
+    // Calls f(Tile*) for each tile of the given classes under area, row by
+    // row, left to right
+    template<typename F>
+    void forEachInArea(const QRectF& area, quint8 classes, F f);
+    
+    // Spatial queries over the solid bitboard (pixel coordinates; outside
+    // the grid is open). Rays visit exactly the cells the segment crosses;
+    // sweeps visit the cells between the start and end boxes and ignore
+    // tiles the box already overlaps, so an embedded box can move out.
+    bool raycast(const QPointF& from, const QPointF& to, TraceHit* hit = nullptr) const;
+    bool sweepBox(const QRectF& box, const QPointF& delta, TraceHit* hit = nullptr) const;
+    bool hasLineOfSight(const QPointF& from, const QPointF& to) const { return !raycast(from, to); }
+    
     // Level state
     void collectCoin(Tile* coin);
     void activateCheckpoint(Tile* checkpoint);
@@ -68,20 +137,35 @@ public:
     bool isComplete() const { return m_complete; }
     void setComplete(bool complete) { m_complete = complete; }
     
+    // Breakable blocks
+    void crumbleTile(Tile* tile);   // Start the crumble timer of an intact block
+    void breakTile(Tile* tile);     // Break at once
+    // Advance crumbling and respawning; a block never grows back into keepClear
+    void updateBreakables(float deltaTime, const QRectF& keepClear);
+    
+    static constexpr float CRUMBLE_TIME = 0.4f;
+    static constexpr float RESPAWN_TIME = 4.0f;
+    
     // Level creation
     void setTile(int x, int y, TileType type, int riddleId = -1);
+    void setBreakable(int x, int y, bool respawns);
     void loadLevel(int levelNumber);
     
-    // Enemy management
-    void addEnemy(Enemy* enemy);
-    QVector<Enemy*>& enemies() { return m_enemies; }
-    const QVector<Enemy*>& enemies() const { return m_enemies; }
+    // Enemy placement
+    void addEnemySpawn(EnemyType type, const QPointF& position, int riddleId = -1, const char* behaviour = nullptr);
+    const QVector<EnemySpawn>& enemySpawns() const { return m_enemySpawns; }
+    
+    // Kinematic platform widthTiles wide, starting at tile (x, y) and
+    // travelling through the given tile positions and back to the start
+    void addMovingPlatform(int x, int y, int widthTiles, const QVector<QPoint>& path, float speed);
+    const QVector<PlatformSpawn>& platformSpawns() const { return m_platformSpawns; }
 
 signals:
     void coinCollected(int remaining);
     void checkpointActivated(QPointF position);
-    void riddleTriggered(int riddleId, Enemy* enemy);
+    void riddleTriggered(int riddleId);
     void levelComplete();
+    void tileChanged(int x, int y);  // A tile changed shape or appearance during play
 
 private:
     void createLevel1();  // Tutorial level
@@ -91,17 +175,67 @@ private:
     void createLevel5();  // Final challenge
     void createLevel6();  // Top-down maze with key
     
+    // Re-file a tile in the class bitboards after it changed
+    void updateTileClasses(const Tile& tile);
+    static quint8 classesOf(const Tile& tile);
+    
+    quint64* rowBits(int classIndex, int y) { return m_rowBits + (classIndex * m_height + y) * m_wordsPerRow; }
+    const quint64* rowBits(int classIndex, int y) const { return m_rowBits + (classIndex * m_height + y) * m_wordsPerRow; }
+    
+    // Clamped cell range an area covers; false if it is off the grid
+    bool cellRange(const QRectF& area, int& startX, int& endX, int& startY, int& endY) const;
+    // Bits startX..endX (inclusive) of word w of a row
+    static quint64 spanMask(int word, int startX, int endX);
+    
     int m_levelNumber;
-    QString m_name;
-    QString m_description;
     int m_width;
     int m_height;
-    QVector<QVector<Tile>> m_tiles;
-    QVector<Enemy*> m_enemies;
+    
+    // Level-scoped storage, released in one shot with the level. Declared
+    // before everything carved out of it so it is destroyed last.
+    LevelArena m_arena;
+    const char* m_name;
+    const char* m_description;
+    Tile* m_tiles;           // m_width * m_height, row-major
+    int m_wordsPerRow;
+    quint64* m_rowBits;      // [class][row][word], from the arena
+    QVector<EnemySpawn> m_enemySpawns;
+    QVector<PlatformSpawn> m_platformSpawns;
+    
+    // Breakables that are crumbling or waiting to respawn
+    struct BreakTimer {
+        Tile* tile;
+        float remaining;
+    };
+    QVector<BreakTimer> m_breakTimers;
     QPointF m_spawnPoint;
+    bool m_dark;
     bool m_complete;
     int m_totalCoins;
     int m_coinsCollected;
 };
 
+template<typename F>
+void Level::forEachInArea(const QRectF& area, quint8 classes, F f) {
+    int startX, endX, startY, endY;
+    if (!cellRange(area, startX, endX, startY, endY)) {
+        return;
+    }
+    
+    for (int y = startY; y <= endY; ++y) {
+        for (int word = startX >> 6; word <= endX >> 6; ++word) {
+            quint64 bits = 0;
+            for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+                if (classes & (1 << c)) bits |= rowBits(c, y)[word];
+            }
+            bits &= spanMask(word, startX, endX);
+            while (bits) {
+                int x = (word << 6) + static_cast<int>(qCountTrailingZeroBits(bits));
+                bits &= bits - 1;
+                f(&m_tiles[y * m_width + x]);
+            }
+        }
+    }
+}
+
 #endif // LEVEL_H
@@ -0,0 +1,61 @@
+#ifndef LEVELARENA_H
+#define LEVELARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Monotonic bump allocator for data that lives exactly as long as a Level.
+// Memory is carved out of large blocks and only returned all at once when the
+// arena is released or destroyed. Destructors are not run by the arena; owners
+// of non-trivial objects must destroy them before the arena goes away.
+class LevelArena {
+public:
+    explicit LevelArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~LevelArena();
+    
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+    
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    
+    // Default-constructed array of count elements
+    template<typename T>
+    T* allocateArray(size_t count) {
+        T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; ++i) {
+            new (data + i) T();
+        }
+        return data;
+    }
+    
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    
+    // Null-terminated copy owned by the arena
+    const char* copyString(const char* str);
+    
+    // Free every block at once
+    void release();
+    
+    size_t bytesUsed() const { return m_used; }
+    
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+private:
+    struct Block {
+        Block* next;
+    };
+    
+    void addBlock(size_t minSize);
+    
+    Block* m_head;
+    char* m_cursor;
+    char* m_end;
+    size_t m_blockSize;
+    size_t m_used;
+};
+
+#endif // LEVELARENA_H
@@ -0,0 +1,86 @@
+#ifndef LEVELCHUNKCACHE_H
+#define LEVELCHUNKCACHE_H
+
+#include "Level.h"
+#include <QAtomicInt>
+#include <QObject>
+#include <QImage>
+#include <QVector>
+
+class JobSystem;
+
+// Pre-renders the static tiles of a level (walls, spikes, torches, intact
+// breakable blocks) into images of CHUNK_COLUMNS tile columns each. Chunks
+// are painted as jobs on the shared JobSystem, one QImage per job, and
+// handed back to the owning thread as they finish. Until a chunk is ready,
+// chunk() returns nullptr and the caller draws those tiles itself, so a
+// rebuild never stalls a frame. When a tile changes during play,
+// invalidate() re-renders just the chunk that holds it.
+//
+// The cache never reads a live Level: the thread that owns the level
+// captures its static tiles and hands the copies over, so the simulation
+// can keep changing the level while the GUI thread paints.
+class LevelChunkCache : public QObject {
+    Q_OBJECT
+
+public:
+    using TilePainter = void (*)(QPainter& painter, const Tile* tile);
+    
+    static constexpr int CHUNK_COLUMNS = 8;
+    
+    // tilePainter must only touch the painter and tile (it runs on workers).
+    // jobs must outlive the cache.
+    LevelChunkCache(TilePainter tilePainter, JobSystem& jobs, QObject* parent = nullptr);
+    ~LevelChunkCache();
+    
+    // Static tiles of a level, chunk by chunk. serial tells level loads
+    // apart, so late updates for a replaced level are dropped.
+    struct Snapshot {
+        int serial = 0;
+        int rows = 0;
+        QVector<QVector<Tile>> chunks;
+    };
+    // Run these on the thread that owns the level
+    static Snapshot capture(const Level* level, int serial);
+    static QVector<Tile> captureChunk(const Level* level, int index);
+    
+    // Throw away all chunks and start rasterizing the captured level
+    void rebuild(const Snapshot& level);
+    
+    // Re-render one chunk of the level with serial from freshly captured
+    // tiles. The chunk reads as not ready until the new image arrives.
+    void invalidate(int serial, int index, const QVector<Tile>& tiles);
+    
+    // Tiles whose current look is baked into chunks
+    static bool isStatic(const Tile& tile) {
+        return tile.type == TileType::SOLID || tile.type == TileType::SPIKE || tile.type == TileType::TORCH
+            || (tile.type == TileType::BREAKABLE && !tile.activated && !tile.collected);
+    }
+    
+    int serial() const { return m_serial; }
+    int chunkCount() const { return m_chunks.size(); }
+    static int chunkForColumn(int column) { return column / CHUNK_COLUMNS; }
+    static QPoint chunkOrigin(int index) { return QPoint(index * CHUNK_COLUMNS * Level::TILE_SIZE, 0); }
+    const QImage* chunk(int index) const;
+    
+    // Block until every queued chunk is painted and delivered
+    void finish();
+
+signals:
+    void chunkReady(int index);
+
+private:
+    void queueChunk(int index, const QVector<Tile>& tiles);
+    void onChunkRendered(int generation, int index, int version, const QImage& image);
+    
+    TilePainter m_tilePainter;
+    JobSystem& m_jobs;
+    QAtomicInt m_pending;       // Chunk jobs not finished yet
+    int m_serial;               // Level the chunks belong to
+    int m_rows;
+    QVector<QImage> m_chunks;   // Null until the worker delivers it
+    QAtomicInt m_generation;    // Bumped on every rebuild to drop stale chunks
+    QVector<int> m_versions;    // Bumped per chunk on invalidate, for the same reason
+};
+
+#endif // LEVELCHUNKCACHE_H
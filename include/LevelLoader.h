@@ -0,0 +1,39 @@
+#ifndef LEVELLOADER_H
+#define LEVELLOADER_H
+
+#include <QObject>
+#include <QThread>
+#include <memory>
+
+class Level;
+
+// Builds levels on a worker thread so the next level is ready before the
+// current one is finished. Finished levels are moved to the thread that owns
+// the loader and handed over through take().
+class LevelLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LevelLoader(QObject* parent = nullptr);
+    ~LevelLoader();
+    
+    // Start building a level in the background (replaces any older request)
+    void prefetch(int levelNumber);
+    
+    // Hand over the prefetched level if it matches, otherwise nullptr.
+    // Ownership passes to the caller; the level has no parent.
+    Level* take(int levelNumber);
+    
+    bool isReady(int levelNumber) const;
+
+private:
+    void onLevelBuilt(std::unique_ptr<Level> level, int request);
+    
+    QThread m_workerThread;
+    QObject* m_worker;       // Lives on m_workerThread, used as invoke target
+    std::unique_ptr<Level> m_ready;
+    int m_requestedLevel;
+    int m_request;           // Bumped on every prefetch to drop stale results
+};
+
+#endif // LEVELLOADER_H
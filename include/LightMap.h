@@ -0,0 +1,78 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include <QImage>
+#include <QPoint>
+#include <QVector>
+
+class Level;
+struct Tile;
+
+// Per-tile light levels for dark levels. Light sources (torches, coins, the
+// key, the goal and the player) flood outwards through open tiles, losing one
+// level per step, and are stopped by solid tiles. Levels are 0..MAX_LIGHT in
+// one byte per tile.
+//
+// Changes are propagated incrementally: when a source appears, disappears or
+// a tile changes, light that came from it is cleared breadth-first and the
+// surrounding light flows back in, so only the affected region is visited.
+// The result is mirrored into a shade mask with one pixel per tile that is
+// drawn scaled up over the scene.
+class LightMap {
+public:
+    static constexpr int MAX_LIGHT = 15;
+    static constexpr int PLAYER_LIGHT = 7;
+    
+    LightMap();
+    
+    // Full rebuild for a level (nullptr or a lit level disables lighting).
+    // The level must outlive the map or be replaced by another reset.
+    void reset(const Level* level);
+    bool isEnabled() const { return m_level != nullptr; }
+    
+    // Re-read a tile after it changed (collected, activated, broken...)
+    void tileChanged(int x, int y);
+    
+    // Move the light the player carries; no work if the cell is unchanged
+    void setPlayerCell(const QPoint& cell);
+    
+    int lightAt(int x, int y) const;
+    // Light a tile is drawn with (walls take the light at their face)
+    int shadeAt(int x, int y) const { return m_shade[y * m_width + x]; }
+    const QVector<quint8>& shadeLevels() const { return m_shade; }   // Row-major
+    
+    // Darkness per tile as premultiplied black, ready to draw scaled up
+    const QImage& shadeMask() const { return m_shadeMask; }
+    static QRgb shadeFor(int light);
+    
+    // Light a tile emits by itself
+    static int emissionOf(const Tile& tile);
+
+private:
+    bool isOpaque(int index) const;
+    int emissionAt(int index) const;
+    void relight(int index);
+    void propagate();
+    void setLight(int index, int light);
+    void updateShade(int index);
+    
+    const Level* m_level;
+    int m_width;
+    int m_height;
+    QPoint m_playerCell;
+    QVector<quint8> m_light;      // Current light per tile, row-major
+    QVector<quint8> m_emission;   // Light emitted by the tile itself
+    QVector<quint8> m_shade;      // Displayed light, mirrored in m_shadeMask
+    
+    // Work queues, kept between updates to avoid reallocating
+    struct Removal {
+        int index;
+        int light;
+    };
+    QVector<Removal> m_removeQueue;
+    QVector<int> m_spreadQueue;
+    
+    QImage m_shadeMask;
+};
+
+#endif // LIGHTMAP_H
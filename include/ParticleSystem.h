@@ -0,0 +1,74 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include <QPointF>
+#include <QRandomGenerator>
+#include <QColor>
+#include <QVector>
+#include "JobSystem.h"
+
+class SpriteSheet;
+
+// Short-lived effects: dust puffs from the player and spark bursts from coins
+// and defeated enemies. Every kind has its own fixed-capacity pool stored as
+// structure-of-arrays and kept packed (live particles first), so integration
+// is a few branch-free loops over contiguous floats that the compiler turns
+// into SIMD. Spawns beyond a pool's capacity are dropped. Pools share
+// nothing, so each kind is updated as its own job.
+class ParticleSystem {
+public:
+    enum class Kind {
+        LAND_DUST,
+        JUMP_DUST,
+        RUN_DUST,
+        COIN_SPARK,
+        DEATH_SPARK,
+        DEBRIS,
+        COUNT
+    };
+    static constexpr int KIND_COUNT = static_cast<int>(Kind::COUNT);
+    
+    // Fixed look and behaviour of a kind
+    struct KindInfo {
+        const SpriteSheet* sheet;  // Animated over the lifetime, or nullptr for a square
+        QRgb color;                // Square colour when there is no sheet
+        int size;                  // Square edge in pixels
+        float gravity;
+        float lifetime;
+        int capacity;
+    };
+    static const KindInfo& info(Kind kind);
+    
+    struct Pool {
+        int count = 0;
+        QVector<float> x;
+        QVector<float> y;
+        QVector<float> vx;
+        QVector<float> vy;
+        QVector<float> age;
+        QVector<quint8> flipped;
+    };
+    
+    ParticleSystem();
+    
+    // position is the particle centre
+    void spawn(Kind kind, const QPointF& position, const QPointF& velocity, bool flipped = false);
+    // count particles flung out in random directions at up to speed px/s
+    void burst(Kind kind, const QPointF& position, int count, float speed);
+    
+    void update(float deltaTime, JobSystem& jobs);
+    void clear();
+    
+    const Pool& pool(Kind kind) const { return m_pools[static_cast<int>(kind)]; }
+    // Sheet frame for particle i of a sprite kind
+    int frameOf(Kind kind, int index) const;
+
+private:
+    void updatePool(int kind, float deltaTime);
+    
+    Pool m_pools[KIND_COUNT];
+    QRandomGenerator m_random;
+    JobSystem::ParallelFor m_poolJobs;   // One job per kind, built once
+};
+
+#endif // PARTICLESYSTEM_H
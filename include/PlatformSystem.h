@@ -0,0 +1,28 @@
+#ifndef PLATFORMSYSTEM_H
+#define PLATFORMSYSTEM_H
+
+#include "EntityStore.h"
+
+// Kinematic moving platforms: PLATFORM entities that follow their waypoint
+// path at a constant speed, ignore gravity and collisions, and carry the
+// enemies standing on them. They are colliders, so the player's collision
+// pass finds them through the collider tree like any other solid.
+class PlatformSystem {
+public:
+    static Entity spawn(EntityStore& store, const QRectF& box, const QVector<QPointF>& waypoints, float speed);
+    
+    // Move every platform, then shift enemies that rode along
+    static void update(EntityStore& store, float deltaTime);
+    
+    // How far the platform under box moved this update (zero if box is not
+    // standing on one). Needs the collider tree synced after update().
+    static QPointF carryDelta(const EntityStore& store, const QRectF& box);
+    
+    // Destroy every platform (level change)
+    static void clear(EntityStore& store);
+    
+    // A rider counts as standing on a platform within this many pixels
+    static constexpr float STANDING_TOLERANCE = 2.0f;
+};
+
+#endif // PLATFORMSYSTEM_H
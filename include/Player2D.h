@@ -5,9 +5,12 @@
 #include <QPointF>
 #include <QRectF>
 #include <QTimer>
-#include <QMap>
-#include "AnimatedSprite.h"
+#include "EntityStore.h"
 
+// The player's gameplay rules on top of its entity: position, velocity,
+// facing and animation are components in the shared EntityStore, while
+// health, lives and score stay here and are reported to the UI through
+// signals.
 class Player2D : public QObject {
     Q_OBJECT
 
@@ -19,19 +22,22 @@ public:
         JUMPING,
         FALLING,
         HURT,
-        DEAD
+        DEAD,
+        THROWING
     };
 
-    explicit Player2D(QObject* parent = nullptr);
+    explicit Player2D(EntityStore& store, QObject* parent = nullptr);
+    
+    Entity entity() const { return m_entity; }
     
     // Position and movement
-    QPointF position() const { return m_position; }
-    void setPosition(const QPointF& pos);
-    QRectF boundingBox() const;
+    QPointF position() const { return m_store.position(m_entity); }
+    void setPosition(const QPointF& pos) { m_store.position(m_entity) = pos; }
+    QRectF boundingBox() const { return m_store.boundingBox(m_entity); }
     
     // Physics
-    QPointF velocity() const { return m_velocity; }
-    void setVelocity(const QPointF& vel) { m_velocity = vel; }
+    QPointF velocity() const { return m_store.velocity(m_entity); }
+    void setVelocity(const QPointF& vel) { m_store.velocity(m_entity) = vel; }
     
     // Movement controls
     void moveLeft();
@@ -39,6 +45,10 @@ public:
     void jump();
     void stopHorizontalMovement();
     
+    // Starts the throw animation and returns true if a throw is allowed
+    // now; the caller launches the projectile
+    bool tryThrow();
+    
     // State
     State state() const { return m_state; }
     void setState(State state);
@@ -68,47 +78,48 @@ public:
     static constexpr float HEIGHT = 32.0f;
 
 signals:
-    void positionChanged(QPointF position);
-    void stateChanged(State state);
     void healthChanged(int health);
     void livesChanged(int lives);
     void scoreChanged(int score);
     void coinsChanged(int coins);
     void died();
     void respawned();
+    void landed();
+    void doubleJumped();
 
 public:
-    // Get current animation sprite
-    AnimatedSprite* getCurrentSprite() { return m_animations[m_state]; }
-    bool isFacingRight() const { return m_facingRight; }
+    // Current animation, or nullptr if its sprite sheet failed to load
+    const AnimationPlayer* getCurrentAnimation() const;
+    bool isFacingRight() const { return m_store.isFacingRight(m_entity); }
 
 private:
-    void loadAnimations();
-    void updateAnimation(float deltaTime);
+    // Shared clip for a state
+    static const AnimationClip& clipFor(State state);
+    // Movement may change the state (not hurt, not mid-throw)
+    bool canChangeState() const;
 
 private:
-    QPointF m_position;
-    QPointF m_velocity;
+    EntityStore& m_store;
+    Entity m_entity;
     QPointF m_spawnPoint;
     State m_state;
     
     bool m_onGround;
     bool m_canJump;
-    bool m_facingRight;
     
     // Double jump mechanics
     bool m_hasDoubleJump;
     float m_doubleJumpCooldown;
     static constexpr float DOUBLE_JUMP_COOLDOWN_TIME = 3.0f;  // 3 second cooldown
     
+    float m_throwCooldown;
+    static constexpr float THROW_COOLDOWN_TIME = 0.35f;
+    
     int m_health;
     int m_lives;
     int m_score;
     int m_coins;
     
-    // Animations
-    QMap<State, AnimatedSprite*> m_animations;
-    
     // Physics constants (properly scaled for smooth gameplay at 60fps)
     static constexpr float GRAVITY = 800.0f;  // Gravity acceleration (pixels/s²)
     static constexpr float FRICTION = 0.85f;  // Friction multiplier for deceleration
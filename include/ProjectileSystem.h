@@ -0,0 +1,68 @@
+#ifndef PROJECTILESYSTEM_H
+#define PROJECTILESYSTEM_H
+
+#include <QPoint>
+#include <QPointF>
+#include <QVector>
+
+class Level;
+class SpriteSheet;
+
+// Thrown rocks, kept like particles: one fixed-capacity structure-of-arrays
+// pool allocated up front, swap-remove on expiry, no allocation while
+// playing. Each update a projectile's whole box is swept along its path for
+// the tick against every solid tile it passes, so however fast it flies it
+// cannot tunnel through a one-tile wall, and a rock that only grazes a tile
+// with its edge still hits it.
+class ProjectileSystem {
+public:
+    enum class Owner : quint8 {
+        PLAYER,
+        ENEMY
+    };
+    
+    struct Pool {
+        int count = 0;
+        QVector<float> x;      // Centre
+        QVector<float> y;
+        QVector<float> vx;
+        QVector<float> vy;
+        QVector<float> age;
+        QVector<quint8> owner;
+    };
+    
+    // Where a projectile stopped against the level this update
+    struct Impact {
+        QPointF position;
+        QPoint cell;
+        Owner owner;
+    };
+    
+    static constexpr int CAPACITY = 8192;
+    static constexpr float GRAVITY = 500.0f;
+    static constexpr float LIFETIME = 3.0f;
+    static constexpr float SIZE = 8.0f;
+    
+    ProjectileSystem();
+    
+    // Dropped silently when the pool is full
+    void spawn(Owner owner, const QPointF& position, const QPointF& velocity);
+    
+    // Move everything, retiring projectiles that hit a solid tile, leave the
+    // level or expire. Wall hits are listed in impacts() until the next update.
+    void update(float deltaTime, const Level& level);
+    
+    // Retire projectile i (after it hit something); the last one takes its slot
+    void remove(int index);
+    void clear();
+    
+    const Pool& pool() const { return m_pool; }
+    const QVector<Impact>& impacts() const { return m_impacts; }
+    static const SpriteSheet* sheet();
+
+private:
+    Pool m_pool;
+    QVector<Impact> m_impacts;
+};
+
+#endif // PROJECTILESYSTEM_H
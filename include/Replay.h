@@ -0,0 +1,54 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+// One input that happened during a recorded run, stamped with the
+// simulation tick it was applied before.
+struct ReplayEvent {
+    enum class Type {
+        KEY_DOWN,
+        KEY_REPEAT,   // Auto-repeated press (toggles like pause react to it)
+        KEY_UP,
+        ANSWER,       // Riddle dialog accepted with text
+        CANCEL,       // Riddle dialog dismissed
+        END           // Session closed after this many ticks
+    };
+    
+    int tick;
+    Type type;
+    int key;
+    QString text;
+};
+
+// Recorded run: every key event and riddle answer, keyed by fixed-timestep
+// tick, so the game can be played back deterministically. Stored as text,
+// one event per line ("<tick> down 16777236", "<tick> answer keyboard"),
+// closed by "<tick> end" with the session's tick count. One file holds one
+// session; games restarted in it keep counting ticks. While recording,
+// events are written out as they happen so a crash or a kiosk power-off
+// keeps everything up to that point (such a file has no end line).
+class Replay {
+public:
+    Replay();
+    
+    bool load(const QString& filePath);
+    const QVector<ReplayEvent>& events() const { return m_events; }
+    int lastTick() const { return m_events.isEmpty() ? 0 : m_events.last().tick; }
+    
+    bool beginRecording(const QString& filePath);
+    bool isRecording() const { return m_file.isOpen(); }
+    void record(const ReplayEvent& event);
+    // Write the END event and close the file
+    void endRecording(int tick);
+
+private:
+    QVector<ReplayEvent> m_events;
+    QFile m_file;
+    QTextStream m_stream;
+};
+
+#endif // REPLAY_H
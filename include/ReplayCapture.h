@@ -0,0 +1,49 @@
+#ifndef REPLAYCAPTURE_H
+#define REPLAYCAPTURE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include "Replay.h"
+
+// Plays a recording back offscreen as fast as the game can simulate and
+// render, and writes every frame out either as numbered PNG files or as
+// raw RGBA on stdout (for piping into an encoder). Encoding runs on a
+// thread pool while the next frames are simulated; raw frames are still
+// written strictly in order.
+class ReplayCapture {
+public:
+    enum class Output {
+        PNG_FILES,
+        RAW_STDOUT
+    };
+    
+    ReplayCapture(Output output, const QString& directory);
+    
+    // Returns the number of frames written, or -1 on error
+    int run(const QVector<ReplayEvent>& events, int maxFrames);
+
+private:
+    void submit(int index, const QImage& frame);
+    void writeReadyFrames();
+    
+    Output m_output;
+    QString m_directory;
+    QFile m_stdout;
+    QThreadPool m_pool;
+    QSemaphore m_slots;        // Bounds the frames in flight
+    
+    // Raw output: encoded frames waiting for their turn
+    QMutex m_mutex;
+    QMap<int, QByteArray> m_readyFrames;
+    int m_nextFrameToWrite;
+    bool m_failed;
+};
+
+#endif // REPLAYCAPTURE_H
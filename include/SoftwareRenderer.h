@@ -0,0 +1,36 @@
+#ifndef SOFTWARERENDERER_H
+#define SOFTWARERENDERER_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include "BlitKernels.h"
+
+// Composes a frame into a premultiplied ARGB32 image with the SIMD span
+// kernels, for machines where QPainter's generic paths are the bottleneck.
+// All sources must be Format_ARGB32_Premultiplied.
+class SoftwareRenderer {
+public:
+    SoftwareRenderer();
+    
+    void resize(const QSize& size);
+    const QImage& frame() const { return m_frame; }
+    QImage& frame() { return m_frame; }
+    
+    // Offset added to every destination position (e.g. minus the camera)
+    void setTranslation(const QPoint& translation) { m_translation = translation; }
+    
+    void clear(QRgb color);
+    void fillRect(const QRect& rect, QRgb color);
+    void blit(const QImage& source, const QRect& sourceRect, const QPoint& position, bool flipped = false);
+    
+    const char* kernelName() const { return m_kernels->name; }
+
+private:
+    QImage m_frame;
+    QPoint m_translation;
+    const BlitKernels::Kernels* m_kernels;
+};
+
+#endif // SOFTWARERENDERER_H
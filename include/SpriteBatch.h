@@ -0,0 +1,39 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <QPainter>
+#include <QPointF>
+#include <QVector>
+#include "AnimationPlayer.h"
+
+// Collects the sprites of a frame and submits them with one
+// drawPixmapFragments call per pixmap. Left-facing sprites are taken from the
+// sheet's pre-mirrored copy, so no painter transform is needed. Buckets keep
+// their capacity between frames.
+class SpriteBatch {
+public:
+    SpriteBatch();
+    
+    // Queue the current frame of an animation with its top-left at position
+    void add(const AnimationPlayer& animation, const QPointF& position, bool facingRight);
+    
+    // Queue one frame of a sheet with its top-left at position
+    void add(const SpriteSheet* sheet, int frame, const QPointF& position, bool facingRight);
+    
+    // Draw everything queued, in the order each pixmap was first added
+    void flush(QPainter& painter);
+    
+    int spriteCount() const { return m_spriteCount; }
+
+private:
+    struct Bucket {
+        const QPixmap* pixmap;
+        QVector<QPainter::PixmapFragment> fragments;
+    };
+    
+    QVector<Bucket> m_buckets;
+    int m_activeBuckets;
+    int m_spriteCount;
+};
+
+#endif // SPRITEBATCH_H
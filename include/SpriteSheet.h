@@ -0,0 +1,51 @@
+#ifndef SPRITESHEET_H
+#define SPRITESHEET_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+// Immutable sprite sheet shared by every entity that plays it: the pixels
+// and the frame rectangles. Sheets are loaded once per file and live for the
+// rest of the program. Playback state lives in AnimationPlayer.
+class SpriteSheet {
+public:
+    // Shared sheet for a file, or nullptr if it cannot be loaded.
+    // Safe to call from any thread (only the image is decoded here).
+    static const SpriteSheet* get(const QString& filePath, int frameWidth, int frameHeight, int frameCount);
+    
+    const QImage& image() const { return m_image; }
+    
+    // Premultiplied ARGB32 copy for the software renderer
+    const QImage& premultipliedImage() const { return m_premultiplied; }
+    
+    // GUI thread only, uploaded on first use
+    const QPixmap& pixmap() const;
+    
+    // Horizontally mirrored copy of the whole sheet, for left-facing sprites.
+    // Frame i of the mirrored sheet is at mirroredFrameRect(i).
+    const QPixmap& mirroredPixmap() const;
+    
+    QRect frameRect(int index) const { return m_frames[index]; }
+    QRect mirroredFrameRect(int index) const {
+        return QRect(m_image.width() - (index + 1) * m_frameWidth, 0, m_frameWidth, m_frameHeight);
+    }
+    int frameCount() const { return m_frames.size(); }
+    int frameWidth() const { return m_frameWidth; }
+    int frameHeight() const { return m_frameHeight; }
+
+private:
+    SpriteSheet(const QImage& image, int frameWidth, int frameHeight, int frameCount);
+    
+    QImage m_image;
+    QImage m_premultiplied;
+    mutable QPixmap m_pixmap;
+    mutable QPixmap m_mirroredPixmap;
+    int m_frameWidth;
+    int m_frameHeight;
+    QVector<QRect> m_frames;
+};
+
+#endif // SPRITESHEET_H
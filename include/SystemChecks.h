@@ -0,0 +1,27 @@
+#ifndef SYSTEMCHECKS_H
+#define SYSTEMCHECKS_H
+
+// Self-checks for the game systems that keep incremental or accelerated
+// state, each compared against a slow but obviously correct version of the
+// same answer. Runs headless with --system-check; the first difference of
+// each check is reported with enough detail to reproduce it.
+class SystemChecks {
+public:
+    // Returns the number of failed checks
+    static int run();
+
+private:
+    // LightMap after random tile edits and player moves against a fresh
+    // flood fill of the whole level
+    static bool checkLighting();
+    
+    // DynamicAabbTree under random inserts, moves and removals against a
+    // linear scan over every proxy
+    static bool checkAabbTree();
+    
+    // An enemy forced to the reduced and sleeping levels of detail, whose
+    // catch-up includes a throw, against the same enemy run every tick
+    static bool checkFarEnemies();
+};
+
+#endif // SYSTEMCHECKS_H
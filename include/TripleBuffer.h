@@ -0,0 +1,53 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+// Lock-free handoff of whole values from one producer to one consumer.
+// Three slots rotate between the roles: the producer fills back() and
+// publish() swaps it with the middle slot; the consumer's acquire() swaps
+// the middle slot for its front() only when something new was published.
+// Neither side ever waits for the other, the consumer always sees a
+// complete value, and the slots are reused so their buffers keep their
+// capacity. back() holds an older value on entry and must be rewritten.
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : m_middle(1)
+        , m_back(2)
+        , m_front(0)
+    {
+    }
+    
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+    
+    // Producer side
+    T& back() { return m_slots[m_back]; }
+    void publish() {
+        // Release: the slot's contents are visible before its index is
+        m_back = m_middle.fetchAndStoreAcqRel(m_back | FRESH) & INDEX_MASK;
+    }
+    
+    // Consumer side. Returns whether front() changed.
+    bool acquire() {
+        if (!(m_middle.loadAcquire() & FRESH)) {
+            return false;
+        }
+        m_front = m_middle.fetchAndStoreAcqRel(m_front) & INDEX_MASK;
+        return true;
+    }
+    const T& front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr int INDEX_MASK = 3;
+    static constexpr int FRESH = 4;   // Middle slot not yet taken by the consumer
+    
+    T m_slots[3];
+    QAtomicInt m_middle;   // Slot index, plus FRESH
+    int m_back;            // Producer only
+    int m_front;           // Consumer only
+};
+
+#endif // TRIPLEBUFFER_H
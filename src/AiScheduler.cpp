@@ -0,0 +1,38 @@
+#include "AiScheduler.h"
+#include "EnemySystem.h"
+
+AiScheduler::AiScheduler()
+    : m_cursor(0)
+    , m_lastServed(0)
+{
+}
+
+void AiScheduler::run(EntityStore& store, const Level& level, const QPointF& target) {
+    const quint32 components = EntityStore::ENEMY | EntityStore::BEHAVIOUR;
+    int living = 0;
+    store.forEach(components, [&store, &living](Entity enemy) {
+        if (!EnemySystem::isDead(store, enemy)) living++;
+    });
+    
+    // Enough per tick to come round to everyone within MAX_STALE_TICKS
+    int quota = (living + MAX_STALE_TICKS - 1) / MAX_STALE_TICKS;
+    int slotCount = store.slotCount();
+    if (m_cursor >= slotCount) {
+        m_cursor = 0;
+    }
+    
+    int served = 0;
+    int next = m_cursor;
+    auto serve = [&](Entity enemy) {
+        if (served == quota || EnemySystem::isDead(store, enemy)) return;
+        EnemySystem::perceive(store, enemy, level, target);
+        next = enemy.index + 1;
+        ++served;
+    };
+    // From the cursor to the end, then round from the start
+    store.forEachInSlots(components, m_cursor, slotCount, serve);
+    store.forEachInSlots(components, 0, m_cursor, serve);
+    
+    m_cursor = next;
+    m_lastServed = served;
+}
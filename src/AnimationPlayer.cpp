@@ -0,0 +1,46 @@
+#include "AnimationPlayer.h"
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<AnimationPlayer>::value, "AnimationPlayer must stay plain data");
+
+void AnimationPlayer::start(const AnimationClip& clip) {
+    sheet = clip.sheet;
+    frameTime = 1.0f / clip.frameRate;
+    loop = clip.loop;
+    reset();
+    play();
+}
+
+void AnimationPlayer::update(float deltaTime) {
+    if (!playing || finished || !sheet) {
+        return;
+    }
+    
+    elapsedTime += deltaTime;
+    
+    if (elapsedTime >= frameTime) {
+        elapsedTime -= frameTime;
+        currentFrame++;
+        
+        if (currentFrame >= sheet->frameCount()) {
+            if (loop) {
+                currentFrame = 0;
+            } else {
+                currentFrame = sheet->frameCount() - 1;
+                finished = true;
+                playing = false;
+            }
+        }
+    }
+}
+
+void AnimationPlayer::play() {
+    playing = true;
+    finished = false;
+}
+
+void AnimationPlayer::reset() {
+    currentFrame = 0;
+    elapsedTime = 0.0f;
+    finished = false;
+}
@@ -0,0 +1,207 @@
+#include "BehaviourVm.h"
+#include "Level.h"
+#include <QDebug>
+#include <QLineF>
+#include <QStringList>
+
+namespace {
+
+// Operand layout per mnemonic: r = register, v = number, l = label
+struct Mnemonic {
+    const char* name;
+    BehaviourVm::Op op;
+    const char* operands;
+};
+
+const Mnemonic MNEMONICS[] = {
+    { "set", BehaviourVm::Op::SET, "rv" },
+    { "add", BehaviourVm::Op::ADD, "rv" },
+    { "dist", BehaviourVm::Op::DIST, "r" },
+    { "sees", BehaviourVm::Op::SEES, "r" },
+    { "jump", BehaviourVm::Op::JUMP, "l" },
+    { "jump_less", BehaviourVm::Op::JUMP_LESS, "rvl" },
+    { "jump_greater", BehaviourVm::Op::JUMP_GREATER, "rvl" },
+    { "face_player", BehaviourVm::Op::FACE_PLAYER, "" },
+    { "patrol", BehaviourVm::Op::PATROL, "" },
+    { "chase", BehaviourVm::Op::CHASE, "v" },
+    { "flee", BehaviourVm::Op::FLEE, "v" },
+    { "idle", BehaviourVm::Op::IDLE, "" },
+    { "wait", BehaviourVm::Op::WAIT, "v" },
+    { "throw", BehaviourVm::Op::THROW, "" },
+};
+
+// Instruction lines with comments and labels stripped; labels map to the
+// index of the instruction that follows them. Fails on a label defined twice.
+bool tokenize(const QString& source, QVector<QStringList>& lines, QHash<QString, int>& labels) {
+    for (QString line : source.split('\n')) {
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        line = line.trimmed();
+        if (line.endsWith(':')) {
+            QString label = line.left(line.size() - 1).trimmed();
+            if (labels.contains(label)) {
+                qDebug() << "Behaviour script: duplicate label" << label;
+                return false;
+            }
+            labels.insert(label, lines.size());
+        } else if (!line.isEmpty()) {
+            lines.append(line.split(' ', Qt::SkipEmptyParts));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int BehaviourVm::load(const QString& source) {
+    auto loaded = m_loaded.constFind(source);
+    if (loaded != m_loaded.constEnd()) {
+        return loaded.value();
+    }
+    
+    QHash<QString, int> labels;
+    QVector<QStringList> lines;
+    if (!tokenize(source, lines, labels)) {
+        return -1;
+    }
+    if (lines.isEmpty()) {
+        qDebug() << "Behaviour script is empty";
+        return -1;
+    }
+    
+    QVector<Instruction> program;
+    program.reserve(lines.size());
+    for (const QStringList& tokens : lines) {
+        const Mnemonic* mnemonic = nullptr;
+        for (const Mnemonic& candidate : MNEMONICS) {
+            if (tokens[0] == QLatin1String(candidate.name)) {
+                mnemonic = &candidate;
+                break;
+            }
+        }
+        if (!mnemonic) {
+            qDebug() << "Behaviour script: unknown instruction" << tokens[0];
+            return -1;
+        }
+        
+        QString operands = QString::fromLatin1(mnemonic->operands);
+        if (tokens.size() != operands.size() + 1) {
+            qDebug() << "Behaviour script: wrong operand count for" << tokens[0];
+            return -1;
+        }
+        
+        Instruction instruction = { mnemonic->op, 0, 0, 0.0f };
+        for (int i = 0; i < operands.size(); ++i) {
+            const QString& token = tokens[i + 1];
+            bool ok = true;
+            if (operands[i] == 'r') {
+                int reg = token.startsWith('r') ? token.mid(1).toInt(&ok) : -1;
+                ok = ok && reg >= 0 && reg < BehaviourComponent::REGISTER_COUNT;
+                instruction.reg = static_cast<quint8>(reg);
+            } else if (operands[i] == 'v') {
+                instruction.value = token.toFloat(&ok);
+            } else {
+                ok = labels.contains(token);
+                instruction.target = static_cast<qint16>(labels.value(token));
+            }
+            if (!ok) {
+                qDebug() << "Behaviour script: bad operand" << token << "for" << tokens[0];
+                return -1;
+            }
+        }
+        program.append(instruction);
+    }
+    
+    m_programs.append({ static_cast<int>(m_code.size()), static_cast<int>(program.size()) });
+    m_code += program;
+    int id = m_programs.size() - 1;
+    m_loaded.insert(source, id);
+    return id;
+}
+
+void BehaviourVm::clear() {
+    m_code.clear();
+    m_programs.clear();
+    m_loaded.clear();
+}
+
+void BehaviourVm::execute(EntityStore& store, Entity enemy, const EnemySystem::Context& context) const {
+    BehaviourComponent& vm = store.behaviour(enemy);
+    if (vm.program < 0 || vm.program >= m_programs.size()) {
+        EnemySystem::setState(store, enemy, EnemyState::WALKING);
+        EnemySystem::patrol(store, enemy, context.level, context.deltaTime);
+        return;
+    }
+    
+    if (vm.wait > 0.0f) {
+        vm.wait -= context.deltaTime;
+        return;
+    }
+    
+    const Program& program = m_programs[vm.program];
+    const Instruction* code = m_code.constData() + program.start;
+    float* registers = vm.registers;
+    QPointF eye = store.boundingBox(enemy).center();
+    
+    for (int steps = 0; steps < STEP_LIMIT; ++steps) {
+        if (vm.pc >= program.length) {
+            vm.pc = 0;   // Scripts loop
+        }
+        
+        const Instruction& instruction = code[vm.pc++];
+        switch (instruction.op) {
+            case Op::SET:
+                registers[instruction.reg] = instruction.value;
+                break;
+            case Op::ADD:
+                registers[instruction.reg] += instruction.value;
+                break;
+            case Op::DIST:
+                registers[instruction.reg] = static_cast<float>(QLineF(eye, context.target).length());
+                break;
+            case Op::SEES:
+                // Perceived by the AiScheduler, up to AiScheduler::MAX_STALE_TICKS ago
+                registers[instruction.reg] = vm.seesTarget ? 1.0f : 0.0f;
+                break;
+            case Op::JUMP:
+                vm.pc = instruction.target;
+                break;
+            case Op::JUMP_LESS:
+                if (registers[instruction.reg] < instruction.value) vm.pc = instruction.target;
+                break;
+            case Op::JUMP_GREATER:
+                if (registers[instruction.reg] > instruction.value) vm.pc = instruction.target;
+                break;
+            case Op::FACE_PLAYER:
+                store.setFacingRight(enemy, context.target.x() > eye.x());
+                break;
+            case Op::PATROL:
+                EnemySystem::setState(store, enemy, EnemyState::WALKING);
+                EnemySystem::patrol(store, enemy, context.level, context.deltaTime);
+                return;
+            case Op::CHASE:
+            case Op::FLEE: {
+                bool towards = (instruction.op == Op::CHASE);
+                float direction = ((context.target.x() > eye.x()) == towards) ? 1.0f : -1.0f;
+                store.setFacingRight(enemy, direction > 0.0f);
+                bool moved = EnemySystem::walk(store, enemy, context.level, direction * instruction.value * context.deltaTime);
+                EnemySystem::setState(store, enemy, moved ? EnemyState::WALKING : EnemyState::IDLE);
+                return;
+            }
+            case Op::IDLE:
+                EnemySystem::setState(store, enemy, EnemyState::IDLE);
+                return;
+            case Op::WAIT:
+                EnemySystem::setState(store, enemy, EnemyState::IDLE);
+                vm.wait = instruction.value;
+                return;
+            case Op::THROW:
+                if (EnemySystem::tryThrow(store, enemy, context.target, *context.launches)) {
+                    return;
+                }
+                break;
+        }
+    }
+}
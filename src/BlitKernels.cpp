@@ -0,0 +1,273 @@
+#include "BlitKernels.h"
+#include <QByteArray>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BLITKERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need per-function targets to use instructions beyond the
+// baseline; MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+// Premultiplied source-over for one pixel: s + d * (255 - sa) / 255
+inline quint32 blendPixel(quint32 d, quint32 s) {
+    quint32 alpha = s >> 24;
+    if (alpha == 255) return s;
+    if (alpha == 0) return d;
+    
+    // Two channels at a time, x / 255 rounded the same way as the SIMD paths
+    quint32 inverse = 255 - alpha;
+    quint32 rb = (d & 0x00ff00ff) * inverse + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    quint32 ag = ((d >> 8) & 0x00ff00ff) * inverse + 0x00800080;
+    ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+    return s + (rb | ag);
+}
+
+void fillScalar(quint32* dst, int count, quint32 color) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = color;
+    }
+}
+
+void blendScalar(quint32* dst, const quint32* src, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[i]);
+    }
+}
+
+void blendFlippedScalar(quint32* dst, const quint32* src, int count) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[count - 1 - i]);
+    }
+}
+
+#ifdef BLITKERNELS_X86
+
+// ---- SSE2: 4 pixels per step ----
+
+TARGET_SSE2 inline __m128i blend4(__m128i s, __m128i d) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xff000000));
+    
+    __m128i alpha = _mm_and_si128(s, alphaMask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xffff) {
+        return s;  // All opaque
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xffff) {
+        return d;  // All transparent
+    }
+    
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i half = _mm_set1_epi16(128);
+    
+    // Widen to 16 bits and broadcast each pixel's alpha over its channels
+    __m128i sLo = _mm_unpacklo_epi8(s, zero);
+    __m128i sHi = _mm_unpackhi_epi8(s, zero);
+    __m128i aLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i aHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    
+    __m128i dLo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, aLo));
+    __m128i dHi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, aHi));
+    
+    // x / 255 ~= (x + 128 + ((x + 128) >> 8)) >> 8
+    dLo = _mm_add_epi16(dLo, half);
+    dHi = _mm_add_epi16(dHi, half);
+    dLo = _mm_srli_epi16(_mm_add_epi16(dLo, _mm_srli_epi16(dLo, 8)), 8);
+    dHi = _mm_srli_epi16(_mm_add_epi16(dHi, _mm_srli_epi16(dHi, 8)), 8);
+    
+    return _mm_add_epi8(s, _mm_packus_epi16(dLo, dHi));
+}
+
+TARGET_SSE2 void fillSse2(quint32* dst, int count, quint32 color) {
+    __m128i value = _mm_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+    }
+    for (; i < count; ++i) {
+        dst[i] = color;
+    }
+}
+
+TARGET_SSE2 void blendSse2(quint32* dst, const quint32* src, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blend4(s, d));
+    }
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[i]);
+    }
+}
+
+TARGET_SSE2 void blendFlippedSse2(quint32* dst, const quint32* src, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + count - i - 4));
+        s = _mm_shuffle_epi32(s, _MM_SHUFFLE(0, 1, 2, 3));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blend4(s, d));
+    }
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[count - 1 - i]);
+    }
+}
+
+// ---- AVX2: 8 pixels per step ----
+
+TARGET_AVX2 inline __m256i blend8(__m256i s, __m256i d) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000));
+    
+    __m256i alpha = _mm256_and_si256(s, alphaMask);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alphaMask)) == -1) {
+        return s;
+    }
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, zero)) == -1) {
+        return d;
+    }
+    
+    const __m256i max = _mm256_set1_epi16(255);
+    const __m256i half = _mm256_set1_epi16(128);
+    
+    // Unpack/pack work per 128-bit lane, so the pixel order is preserved
+    __m256i sLo = _mm256_unpacklo_epi8(s, zero);
+    __m256i sHi = _mm256_unpackhi_epi8(s, zero);
+    __m256i aLo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sLo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    __m256i aHi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(sHi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    
+    __m256i dLo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(max, aLo));
+    __m256i dHi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(max, aHi));
+    
+    dLo = _mm256_add_epi16(dLo, half);
+    dHi = _mm256_add_epi16(dHi, half);
+    dLo = _mm256_srli_epi16(_mm256_add_epi16(dLo, _mm256_srli_epi16(dLo, 8)), 8);
+    dHi = _mm256_srli_epi16(_mm256_add_epi16(dHi, _mm256_srli_epi16(dHi, 8)), 8);
+    
+    return _mm256_add_epi8(s, _mm256_packus_epi16(dLo, dHi));
+}
+
+TARGET_AVX2 void fillAvx2(quint32* dst, int count, quint32 color) {
+    __m256i value = _mm256_set1_epi32(static_cast<int>(color));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+    }
+    for (; i < count; ++i) {
+        dst[i] = color;
+    }
+}
+
+TARGET_AVX2 void blendAvx2(quint32* dst, const quint32* src, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), blend8(s, d));
+    }
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[i]);
+    }
+}
+
+TARGET_AVX2 void blendFlippedAvx2(quint32* dst, const quint32* src, int count) {
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + count - i - 8));
+        s = _mm256_permutevar8x32_epi32(s, reverse);
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), blend8(s, d));
+    }
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], src[count - 1 - i]);
+    }
+}
+
+bool cpuHasSse2() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx2() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+const BlitKernels::Kernels sse2Kernels = { fillSse2, blendSse2, blendFlippedSse2, "sse2" };
+const BlitKernels::Kernels avx2Kernels = { fillAvx2, blendAvx2, blendFlippedAvx2, "avx2" };
+
+#endif // BLITKERNELS_X86
+
+const BlitKernels::Kernels scalarKernels = { fillScalar, blendScalar, blendFlippedScalar, "scalar" };
+
+const BlitKernels::Kernels& detect() {
+    QByteArray forced = qgetenv("DEATHRIDDLE_BLIT_KERNEL");
+
+#ifdef BLITKERNELS_X86
+    bool avx2 = cpuHasAvx2();
+    bool sse2 = cpuHasSse2();
+    
+    if (forced == "scalar") {
+        return scalarKernels;
+    }
+    if (forced == "sse2" && sse2) {
+        return sse2Kernels;
+    }
+    if (avx2 && (forced.isEmpty() || forced == "avx2")) {
+        return avx2Kernels;
+    }
+    if (sse2) {
+        return sse2Kernels;
+    }
+#else
+    Q_UNUSED(forced);
+#endif
+    return scalarKernels;
+}
+
+}
+
+const BlitKernels::Kernels& BlitKernels::select() {
+    static const Kernels& selected = detect();
+    return selected;
+}
+
+const BlitKernels::Kernels& BlitKernels::scalar() {
+    return scalarKernels;
+}
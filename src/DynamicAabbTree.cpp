@@ -0,0 +1,255 @@
+#include "DynamicAabbTree.h"
+#include <algorithm>
+
+DynamicAabbTree::DynamicAabbTree()
+    : m_root(NULL_NODE)
+    , m_freeList(NULL_NODE)
+{
+}
+
+void DynamicAabbTree::clear() {
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+}
+
+int DynamicAabbTree::allocateNode() {
+    int index;
+    if (m_freeList != NULL_NODE) {
+        index = m_freeList;
+        m_freeList = m_nodes[index].parent;
+    } else {
+        index = m_nodes.size();
+        m_nodes.append(Node());
+    }
+    
+    Node& node = m_nodes[index];
+    node.userData = -1;
+    node.parent = NULL_NODE;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = 0;
+    return index;
+}
+
+void DynamicAabbTree::freeNode(int index) {
+    m_nodes[index].parent = m_freeList;
+    m_nodes[index].height = -1;
+    m_freeList = index;
+}
+
+int DynamicAabbTree::createProxy(const QRectF& box, int userData) {
+    int proxy = allocateNode();
+    m_nodes[proxy].box = box.adjusted(-MARGIN, -MARGIN, MARGIN, MARGIN);
+    m_nodes[proxy].userData = userData;
+    insertLeaf(proxy);
+    return proxy;
+}
+
+void DynamicAabbTree::destroyProxy(int proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+}
+
+bool DynamicAabbTree::moveProxy(int proxy, const QRectF& box, const QPointF& displacement) {
+    if (m_nodes[proxy].box.contains(box)) {
+        return false;
+    }
+    
+    removeLeaf(proxy);
+    
+    // Extend the fat box the way the collider is heading
+    QRectF fat = box.adjusted(-MARGIN, -MARGIN, MARGIN, MARGIN);
+    QPointF ahead = displacement * DISPLACEMENT_MULTIPLIER;
+    if (ahead.x() < 0) fat.setLeft(fat.left() + ahead.x()); else fat.setRight(fat.right() + ahead.x());
+    if (ahead.y() < 0) fat.setTop(fat.top() + ahead.y()); else fat.setBottom(fat.bottom() + ahead.y());
+    m_nodes[proxy].box = fat;
+    
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::insertLeaf(int leaf) {
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+    
+    // Walk down to the sibling that grows the total perimeter least
+    QRectF leafBox = m_nodes[leaf].box;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf()) {
+        const Node& node = m_nodes[index];
+        float area = perimeter(node.box);
+        float combined = perimeter(node.box.united(leafBox));
+        
+        // Cost of pairing with this node, and of pushing the leaf further down
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - area);
+        
+        auto descendCost = [this, &leafBox, inheritance](int child) {
+            const Node& c = m_nodes[child];
+            float grown = perimeter(c.box.united(leafBox));
+            return (c.isLeaf() ? grown : grown - perimeter(c.box)) + inheritance;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+        
+        if (cost < cost1 && cost < cost2) break;
+        index = (cost1 < cost2) ? node.child1 : node.child2;
+    }
+    
+    int sibling = index;
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = allocateNode();  // May reallocate m_nodes
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].box = leafBox.united(m_nodes[sibling].box);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    
+    if (oldParent == NULL_NODE) {
+        m_root = newParent;
+    } else if (m_nodes[oldParent].child1 == sibling) {
+        m_nodes[oldParent].child1 = newParent;
+    } else {
+        m_nodes[oldParent].child2 = newParent;
+    }
+    
+    refitAncestors(m_nodes[leaf].parent);
+}
+
+void DynamicAabbTree::removeLeaf(int leaf) {
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+    
+    int parent = m_nodes[leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+    
+    // The sibling takes the parent's place
+    if (grandParent == NULL_NODE) {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+    
+    if (m_nodes[grandParent].child1 == parent) {
+        m_nodes[grandParent].child1 = sibling;
+    } else {
+        m_nodes[grandParent].child2 = sibling;
+    }
+    m_nodes[sibling].parent = grandParent;
+    freeNode(parent);
+    
+    refitAncestors(grandParent);
+}
+
+void DynamicAabbTree::refitAncestors(int index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+        
+        Node& node = m_nodes[index];
+        const Node& child1 = m_nodes[node.child1];
+        const Node& child2 = m_nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = child1.box.united(child2.box);
+        
+        index = node.parent;
+    }
+}
+
+int DynamicAabbTree::balance(int iA) {
+    Node& a = m_nodes[iA];
+    if (a.isLeaf() || a.height < 2) {
+        return iA;
+    }
+    
+    int iB = a.child1;
+    int iC = a.child2;
+    Node& b = m_nodes[iB];
+    Node& c = m_nodes[iC];
+    int heightDifference = c.height - b.height;
+    
+    // Rotate the taller child up into A's place
+    auto replaceInParent = [this](int parent, int oldChild, int newChild) {
+        if (parent == NULL_NODE) {
+            m_root = newChild;
+        } else if (m_nodes[parent].child1 == oldChild) {
+            m_nodes[parent].child1 = newChild;
+        } else {
+            m_nodes[parent].child2 = newChild;
+        }
+    };
+    
+    if (heightDifference > 1) {
+        int iF = c.child1;
+        int iG = c.child2;
+        Node& f = m_nodes[iF];
+        Node& g = m_nodes[iG];
+        
+        c.child1 = iA;
+        c.parent = a.parent;
+        a.parent = iC;
+        replaceInParent(c.parent, iA, iC);
+        
+        // The taller grandchild stays with C, the other moves under A
+        if (f.height > g.height) {
+            c.child2 = iF;
+            a.child2 = iG;
+            g.parent = iA;
+            a.box = b.box.united(g.box);
+            c.box = a.box.united(f.box);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.child2 = iG;
+            a.child2 = iF;
+            f.parent = iA;
+            a.box = b.box.united(f.box);
+            c.box = a.box.united(g.box);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+        return iC;
+    }
+    
+    if (heightDifference < -1) {
+        int iD = b.child1;
+        int iE = b.child2;
+        Node& d = m_nodes[iD];
+        Node& e = m_nodes[iE];
+        
+        b.child1 = iA;
+        b.parent = a.parent;
+        a.parent = iB;
+        replaceInParent(b.parent, iA, iB);
+        
+        if (d.height > e.height) {
+            b.child2 = iD;
+            a.child1 = iE;
+            e.parent = iA;
+            a.box = c.box.united(e.box);
+            b.box = a.box.united(d.box);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.child2 = iE;
+            a.child1 = iD;
+            d.parent = iA;
+            a.box = c.box.united(d.box);
+            b.box = a.box.united(e.box);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+        return iB;
+    }
+    
+    return iA;
+}
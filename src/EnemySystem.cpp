@@ -0,0 +1,307 @@
+#include "EnemySystem.h"
+#include "BehaviourVm.h"
+#include "JobSystem.h"
+#include "Level.h"
+#include "ProjectileSystem.h"
+#include <QDebug>
+#include <QLineF>
+#include <algorithm>
+
+const AnimationClip& EnemySystem::clipFor(EnemyType type, EnemyState state) {
+    // Built once per type; the sheets themselves are shared with every enemy
+    auto makeClips = [](const QString& prefix) {
+        QString basePath = "assets/sprites/" + prefix;
+        QVector<AnimationClip> clips(5);
+        clips[static_cast<int>(EnemyState::IDLE)] =
+            { SpriteSheet::get(basePath + "Idle_4.png", 32, 32, 4), 8.0f, true };
+        clips[static_cast<int>(EnemyState::WALKING)] =
+            { SpriteSheet::get(basePath + "Walk_6.png", 32, 32, 6), 12.0f, true };
+        clips[static_cast<int>(EnemyState::HURT)] =
+            { SpriteSheet::get(basePath + "Hurt_4.png", 32, 32, 4), 12.0f, false };
+        clips[static_cast<int>(EnemyState::DEAD)] =
+            { SpriteSheet::get(basePath + "Death_8.png", 32, 32, 8), 12.0f, false };
+        clips[static_cast<int>(EnemyState::THROWING)] =
+            { SpriteSheet::get(basePath + "Throw_4.png", 32, 32, 4), 12.0f, false };
+        return clips;
+    };
+    
+    static const QVector<AnimationClip> pinkClips = makeClips("Pink_Monster_");
+    static const QVector<AnimationClip> owletClips = makeClips("Owlet_Monster_");
+    
+    const QVector<AnimationClip>& clips = (type == EnemyType::PINK_MONSTER) ? pinkClips : owletClips;
+    return clips[static_cast<int>(state)];
+}
+
+Entity EnemySystem::spawn(EntityStore& store, EnemyType type, const QPointF& position, int riddleId, int program) {
+    Entity enemy = store.create(EntityStore::TRANSFORM | EntityStore::BODY | EntityStore::SPRITE
+                                | EntityStore::ENEMY | EntityStore::COLLIDER | EntityStore::BEHAVIOUR);
+    store.position(enemy) = position;
+    store.size(enemy) = QSizeF(WIDTH, HEIGHT);
+    store.setFacingRight(enemy, false);
+    
+    EnemyComponent& data = store.enemy(enemy);
+    data.type = type;
+    data.state = EnemyState::IDLE;
+    data.riddleId = riddleId;
+    data.riddleTriggered = false;
+    data.patrolOrigin = position;
+    data.patrolDistance = PATROL_DISTANCE;
+    data.patrolSpeed = PATROL_SPEED;
+    data.throwCooldown = THROW_INTERVAL;
+    data.pendingTime = 0.0f;
+    store.behaviour(enemy).program = program;
+    
+    store.animation(enemy).start(clipFor(type, data.state));
+    return enemy;
+}
+
+void EnemySystem::update(EntityStore& store, const BehaviourVm& behaviours, const Context& context,
+                         ProjectileSystem& projectiles, JobSystem& jobs) {
+    int rangeCount = (store.slotCount() + UPDATE_GRAIN - 1) / UPDATE_GRAIN;
+    if (m_launches.size() < std::max(rangeCount, 1)) {
+        m_launches.resize(std::max(rangeCount, 1));
+    }
+    for (QVector<Launch>& launches : m_launches) {
+        launches.clear();   // Keeps the capacity
+    }
+    
+    // A single range, or nobody to share the ranges with: no graph at all
+    if (rangeCount <= 1 || jobs.workerCount() == 0) {
+        Context all = context;
+        all.launches = &m_launches[0];
+        updateSlots(store, behaviours, all, 0, store.slotCount());
+        spawnLaunches(projectiles, 1);
+        return;
+    }
+    
+    m_store = &store;
+    m_behaviours = &behaviours;
+    m_context = &context;
+    m_projectiles = &projectiles;
+    if (rangeCount != m_rangeCount) {
+        m_graph.clear();
+        QVector<int> ranges;
+        for (int range = 0; range < rangeCount; ++range) {
+            ranges.append(m_graph.add([this, range]() { runRange(range); }));
+        }
+        // Range order is slot order, as if one thread had run them all
+        m_graph.add([this]() { spawnLaunches(*m_projectiles, m_rangeCount); }, ranges);
+        m_rangeCount = rangeCount;
+    }
+    jobs.run(m_graph);
+}
+
+void EnemySystem::runRange(int range) {
+    Context rangeContext = *m_context;
+    rangeContext.launches = &m_launches[range];
+    int begin = range * UPDATE_GRAIN;
+    updateSlots(*m_store, *m_behaviours, rangeContext, begin, std::min(m_store->slotCount(), begin + UPDATE_GRAIN));
+}
+
+void EnemySystem::spawnLaunches(ProjectileSystem& projectiles, int rangeCount) {
+    for (int range = 0; range < rangeCount; ++range) {
+        for (const Launch& launch : m_launches[range]) {
+            projectiles.spawn(ProjectileSystem::Owner::ENEMY, launch.origin, launch.velocity);
+        }
+    }
+}
+
+void EnemySystem::updateSlots(EntityStore& store, const BehaviourVm& behaviours, const Context& context, int begin, int end) {
+    store.forEachInSlots(EntityStore::ENEMY | EntityStore::BEHAVIOUR, begin, end, [&store, &behaviours, &context](Entity enemy) {
+        EnemyComponent& data = store.enemy(enemy);
+        if (data.state == EnemyState::DEAD) {
+            // The death animation always plays out so the enemy can be released
+            store.removeComponents(enemy, EntityStore::DORMANT);
+            return;
+        }
+        
+        data.pendingTime += context.deltaTime;
+        Detail detail = detailFor(store.boundingBox(enemy), context.viewport);
+        if (isPlayingReaction(store, enemy)) {
+            // A frozen hurt or throw clip would never finish and the script
+            // would never resume, so these play out at the full rate
+            detail = Detail::ACTIVE;
+        }
+        if (detail == Detail::ACTIVE) {
+            store.removeComponents(enemy, EntityStore::DORMANT);
+        } else {
+            store.addComponents(enemy, EntityStore::DORMANT);
+            if (detail == Detail::ASLEEP || (context.tick + enemy.index) % REDUCED_INTERVAL != 0) {
+                data.pendingTime = std::min(data.pendingTime, MAX_CATCH_UP);
+                return;
+            }
+        }
+        
+        // Everything owed, in steps no longer than a reduced-rate tick.
+        // updateAnimations skips a dormant enemy, so a throw made during the
+        // catch-up plays its clip here, step by step, and the script resumes
+        // within the same catch-up once it ends.
+        bool dormant = detail != Detail::ACTIVE;
+        Context step = context;
+        float remaining = data.pendingTime;
+        data.pendingTime = 0.0f;
+        while (remaining > 0.0f) {
+            step.deltaTime = std::min(remaining, MAX_STEP);
+            remaining -= step.deltaTime;
+            think(store, enemy, behaviours, step);
+            if (dormant && isPlayingReaction(store, enemy)) {
+                store.animation(enemy).update(step.deltaTime);
+            }
+        }
+    });
+}
+
+EnemySystem::Detail EnemySystem::detailFor(const QRectF& box, const QRectF& viewport) {
+    // Distance outside the viewport along the worse axis
+    qreal dx = std::max({ viewport.left() - box.right(), box.left() - viewport.right(), qreal(0) });
+    qreal dy = std::max({ viewport.top() - box.bottom(), box.top() - viewport.bottom(), qreal(0) });
+    qreal distance = std::max(dx, dy);
+    if (distance <= ACTIVE_MARGIN) return Detail::ACTIVE;
+    if (distance <= REDUCED_MARGIN) return Detail::REDUCED;
+    return Detail::ASLEEP;
+}
+
+bool EnemySystem::isPlayingReaction(const EntityStore& store, Entity enemy) {
+    EnemyState state = store.enemy(enemy).state;
+    if (state != EnemyState::HURT && state != EnemyState::THROWING) {
+        return false;
+    }
+    const AnimationPlayer& animation = store.animation(enemy);
+    return animation.isLoaded() && !animation.isFinished();
+}
+
+void EnemySystem::think(EntityStore& store, Entity enemy, const BehaviourVm& behaviours, const Context& context) {
+    EnemyComponent& data = store.enemy(enemy);
+    data.throwCooldown = std::max(0.0f, data.throwCooldown - context.deltaTime);
+    
+    // Hurt and throwing play out before the script resumes
+    if (isPlayingReaction(store, enemy)) {
+        return;
+    }
+    
+    behaviours.execute(store, enemy, context);
+}
+
+QString EnemySystem::defaultBehaviour(EnemyType type) {
+    if (type == EnemyType::OWLET_MONSTER) {
+        // Throw at a visible player within range, otherwise patrol
+        return QStringLiteral(
+            "    dist r0\n"
+            "    jump_greater r0 320 walk\n"
+            "    sees r0\n"
+            "    jump_less r0 1 walk\n"
+            "    throw\n"
+            "walk:\n"
+            "    patrol\n");
+    }
+    return QStringLiteral("    patrol\n");
+}
+
+void EnemySystem::patrol(EntityStore& store, Entity enemy, const Level& level, float deltaTime) {
+    // Walk left and right around the spawn point, turning early at walls
+    // and, when standing on tiles, at ledges
+    const EnemyComponent& data = store.enemy(enemy);
+    bool facingRight = store.isFacingRight(enemy);
+    float distance = store.position(enemy).x() - data.patrolOrigin.x();
+    float step = data.patrolSpeed * deltaTime;
+    
+    bool turn = facingRight ? distance > data.patrolDistance : distance < -data.patrolDistance;
+    if (!walk(store, enemy, level, facingRight ? step : -step) || turn) {
+        store.setFacingRight(enemy, !facingRight);
+    }
+}
+
+bool EnemySystem::walk(EntityStore& store, Entity enemy, const Level& level, float dx) {
+    QPointF& position = store.position(enemy);
+    QRectF box = store.boundingBox(enemy);
+    
+    TraceHit wall;
+    if (level.sweepBox(box, QPointF(dx, 0), &wall)) {
+        position.setX(wall.position.x());   // Up to the wall
+        return false;
+    }
+    
+    // Only enemies with tiles under their feet look for ledges; ones on
+    // moving platforms or in the air walk freely
+    QRectF ground(box.left(), box.bottom(), box.width(), LEDGE_PROBE);
+    if (level.isAreaSolid(ground)) {
+        qreal leadingEdge = dx > 0.0f ? box.right() + dx : box.left() + dx;
+        QRectF ahead(dx > 0.0f ? leadingEdge - 1.0 : leadingEdge, box.bottom(), 1.0, LEDGE_PROBE);
+        if (!level.isAreaSolid(ahead)) {
+            return false;
+        }
+    }
+    
+    position.setX(position.x() + dx);
+    return true;
+}
+
+bool EnemySystem::tryThrow(EntityStore& store, Entity enemy, const QPointF& target, QVector<Launch>& launches) {
+    EnemyComponent& data = store.enemy(enemy);
+    if (data.throwCooldown > 0.0f) {
+        return false;
+    }
+    data.throwCooldown = THROW_INTERVAL;
+    throwAt(store, enemy, target, launches);
+    return true;
+}
+
+void EnemySystem::perceive(EntityStore& store, Entity enemy, const Level& level, const QPointF& target) {
+    store.behaviour(enemy).seesTarget = level.hasLineOfSight(store.boundingBox(enemy).center(), target);
+}
+
+void EnemySystem::throwAt(EntityStore& store, Entity enemy, const QPointF& target, QVector<Launch>& launches) {
+    QPointF origin = store.boundingBox(enemy).center();
+    QPointF offset = target - origin;
+    store.setFacingRight(enemy, offset.x() > 0);
+    setState(store, enemy, EnemyState::THROWING);
+    
+    // Aimed straight at the target with a little loft against gravity
+    qreal length = std::max<qreal>(1.0, QLineF(origin, target).length());
+    QPointF velocity = offset * (THROW_SPEED / length);
+    qreal flightTime = length / THROW_SPEED;
+    velocity.ry() -= 0.5 * ProjectileSystem::GRAVITY * flightTime;
+    launches.append({ origin, velocity });
+}
+
+void EnemySystem::setState(EntityStore& store, Entity enemy, EnemyState state) {
+    EnemyComponent& data = store.enemy(enemy);
+    if (data.state != state) {
+        data.state = state;
+        // Restart animation when state changes
+        store.animation(enemy).start(clipFor(data.type, state));
+    }
+}
+
+void EnemySystem::takeDamage(EntityStore& store, Entity enemy) {
+    EnemyState state = store.enemy(enemy).state;
+    if (state != EnemyState::DEAD && state != EnemyState::HURT) {
+        setState(store, enemy, EnemyState::HURT);
+    }
+}
+
+void EnemySystem::die(EntityStore& store, Entity enemy) {
+    setState(store, enemy, EnemyState::DEAD);
+    // Ensure death animation plays
+    store.animation(enemy).start(clipFor(store.enemy(enemy).type, EnemyState::DEAD));
+}
+
+bool EnemySystem::isDeathAnimationFinished(const EntityStore& store, Entity enemy) {
+    const AnimationPlayer& animation = store.animation(enemy);
+    return isDead(store, enemy) && animation.isLoaded() && animation.isFinished();
+}
+
+void EnemySystem::releaseFinished(EntityStore& store) {
+    store.forEach(EntityStore::ENEMY, [&store](Entity enemy) {
+        if (isDeathAnimationFinished(store, enemy)) {
+            qDebug() << "Removing dead enemy after animation finished";
+            store.destroy(enemy);
+        }
+    });
+}
+
+void EnemySystem::clear(EntityStore& store) {
+    store.forEach(EntityStore::ENEMY, [&store](Entity enemy) {
+        store.destroy(enemy);
+    });
+}
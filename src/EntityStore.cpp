@@ -0,0 +1,104 @@
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+EntityStore::EntityStore(int capacity)
+    : m_count(0)
+{
+    m_masks.reserve(capacity);
+    m_generations.reserve(capacity);
+    m_freeSlots.reserve(capacity);
+    m_positions.reserve(capacity);
+    m_velocities.reserve(capacity);
+    m_sizes.reserve(capacity);
+    m_animations.reserve(capacity);
+    m_facingRight.reserve(capacity);
+    m_enemies.reserve(capacity);
+    m_platforms.reserve(capacity);
+    m_behaviours.reserve(capacity);
+    m_proxies.reserve(capacity);
+    m_syncedPositions.reserve(capacity);
+}
+
+Entity EntityStore::create(quint32 components) {
+    int index;
+    if (!m_freeSlots.isEmpty()) {
+        index = m_freeSlots.takeLast();
+    } else {
+        // Every component array grows together so indices stay in step
+        index = m_masks.size();
+        m_masks.append(0);
+        m_generations.append(0);
+        m_positions.append(QPointF());
+        m_velocities.append(QPointF());
+        m_sizes.append(QSizeF());
+        m_animations.append(AnimationPlayer());
+        m_facingRight.append(0);
+        m_enemies.append(EnemyComponent());
+        m_platforms.append(PlatformComponent());
+        m_behaviours.append(BehaviourComponent());
+        m_proxies.append(DynamicAabbTree::NULL_NODE);
+        m_syncedPositions.append(QPointF());
+    }
+    
+    // Recycled slots start from clean components
+    m_masks[index] = components;
+    m_positions[index] = QPointF();
+    m_velocities[index] = QPointF();
+    m_sizes[index] = QSizeF();
+    m_animations[index] = AnimationPlayer();
+    m_facingRight[index] = 0;
+    m_enemies[index] = EnemyComponent();
+    m_platforms[index] = PlatformComponent();
+    m_behaviours[index] = BehaviourComponent();
+    m_count++;
+    return Entity{ index, m_generations[index] };
+}
+
+void EntityStore::destroy(Entity entity) {
+    if (!isAlive(entity)) return;
+    
+    if (m_proxies[entity.index] != DynamicAabbTree::NULL_NODE) {
+        m_colliders.destroyProxy(m_proxies[entity.index]);
+        m_proxies[entity.index] = DynamicAabbTree::NULL_NODE;
+    }
+    m_masks[entity.index] = 0;
+    m_generations[entity.index]++;
+    m_freeSlots.append(entity.index);
+    m_count--;
+}
+
+bool EntityStore::isAlive(Entity entity) const {
+    return entity.index >= 0 && entity.index < m_masks.size()
+        && m_masks[entity.index] != 0 && m_generations[entity.index] == entity.generation;
+}
+
+bool EntityStore::has(Entity entity, quint32 components) const {
+    return isAlive(entity) && (m_masks[entity.index] & components) == components;
+}
+
+void EntityStore::updateAnimations(float deltaTime, JobSystem& jobs) {
+    // Taken here so no job touches the vectors themselves
+    const quint32* masks = m_masks.constData();
+    AnimationPlayer* animations = m_animations.data();
+    m_animationJobs.run(jobs, m_masks.size(), ANIMATION_GRAIN, [masks, animations, deltaTime](int begin, int end) {
+        for (int index = begin; index < end; ++index) {
+            if ((masks[index] & (SPRITE | DORMANT)) == SPRITE) {
+                animations[index].update(deltaTime);
+            }
+        }
+    });
+}
+
+void EntityStore::syncColliders() {
+    for (int index = 0; index < m_masks.size(); ++index) {
+        if (!(m_masks[index] & COLLIDER)) continue;
+        
+        QRectF box(m_positions[index], m_sizes[index]);
+        if (m_proxies[index] == DynamicAabbTree::NULL_NODE) {
+            m_proxies[index] = m_colliders.createProxy(box, index);
+        } else {
+            m_colliders.moveProxy(m_proxies[index], box, m_positions[index] - m_syncedPositions[index]);
+        }
+        m_syncedPositions[index] = m_positions[index];
+    }
+}
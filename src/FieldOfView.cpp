@@ -0,0 +1,125 @@
+#include "FieldOfView.h"
+#include "Level.h"
+
+FieldOfView::FieldOfView()
+    : m_width(0)
+    , m_height(0)
+    , m_origin(-1, -1)
+{
+}
+
+void FieldOfView::reset(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_origin = QPoint(-1, -1);
+    m_cells.fill(UNEXPLORED, width * height);
+    m_visibleCells.clear();
+    
+    if (width > 0 && height > 0) {
+        m_fogMask = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+        m_fogMask.fill(UNEXPLORED_FOG);
+    } else {
+        m_fogMask = QImage();
+    }
+}
+
+bool FieldOfView::update(const Level& level, const QPoint& cell, int radius) {
+    if (!isEnabled() || cell == m_origin) {
+        return false;
+    }
+    m_origin = cell;
+    
+    // Last view becomes memory
+    for (int index : m_visibleCells) {
+        setCell(index % m_width, index / m_width, EXPLORED);
+    }
+    m_visibleCells.clear();
+    
+    markVisible(cell.x(), cell.y());
+    
+    // One pass per octant; (xx, xy, yx, yy) maps octant space to the grid
+    static const int octants[8][4] = {
+        { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+        {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1}
+    };
+    for (const auto& octant : octants) {
+        castLight(level, 1, 1.0f, 0.0f, radius, octant[0], octant[1], octant[2], octant[3]);
+    }
+    return true;
+}
+
+FieldOfView::CellState FieldOfView::cellState(int x, int y) const {
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+        return UNEXPLORED;
+    }
+    return static_cast<CellState>(m_cells[y * m_width + x]);
+}
+
+void FieldOfView::setCell(int x, int y, CellState state) {
+    m_cells[y * m_width + x] = state;
+    
+    QRgb fog = (state == VISIBLE) ? 0 : (state == EXPLORED) ? EXPLORED_FOG : UNEXPLORED_FOG;
+    reinterpret_cast<QRgb*>(m_fogMask.scanLine(y))[x] = fog;
+}
+
+void FieldOfView::markVisible(int x, int y) {
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
+        return;
+    }
+    if (m_cells[y * m_width + x] != VISIBLE) {
+        setCell(x, y, VISIBLE);
+        m_visibleCells.append(y * m_width + x);
+    }
+}
+
+void FieldOfView::castLight(const Level& level, int row, float startSlope, float endSlope,
+                            int radius, int xx, int xy, int yx, int yy) {
+    if (startSlope < endSlope) {
+        return;
+    }
+    
+    float nextStartSlope = startSlope;
+    for (int distance = row; distance <= radius; ++distance) {
+        bool blocked = false;
+        int dy = -distance;
+        
+        for (int dx = -distance; dx <= 0; ++dx) {
+            // Slopes through the corners of this cell
+            float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+            float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+            if (startSlope < rightSlope) {
+                continue;
+            }
+            if (endSlope > leftSlope) {
+                break;
+            }
+            
+            int x = m_origin.x() + dx * xx + dy * xy;
+            int y = m_origin.y() + dx * yx + dy * yy;
+            if (dx * dx + dy * dy <= radius * radius) {
+                markVisible(x, y);
+            }
+            
+            const Tile* tile = level.getTileAt(x, y);
+            bool opaque = !tile || tile->type == TileType::SOLID;
+            
+            if (blocked) {
+                if (opaque) {
+                    nextStartSlope = rightSlope;
+                } else {
+                    blocked = false;
+                    startSlope = nextStartSlope;
+                }
+            } else if (opaque && distance < radius) {
+                // Scan the lit part beyond this wall, then keep going past it
+                blocked = true;
+                castLight(level, distance + 1, startSlope, leftSlope, radius, xx, xy, yx, yy);
+                nextStartSlope = rightSlope;
+            }
+        }
+        
+        if (blocked) {
+            break;
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "GameWidget.h"
-#include "Enemy.h"
+#include "EnemySystem.h"
+#include "PlatformSystem.h"
 #include <QPainter>
 #include <QKeyEvent>
 #include <QPaintEvent>
@@ -7,31 +8,50 @@
 #include <QMessageBox>
 #include <QInputDialog>
 #include <QPushButton>
+#include <QStaticText>
+#include <QVarLengthArray>
 #include <cmath>
 
 GameWidget::GameWidget(QWidget* parent)
     : QWidget(parent)
-    , m_player(new Player2D(this))
+    , m_simulation(new QObject)
+    , m_headless(false)
+    , m_player(new Player2D(m_entities, this))
     , m_currentLevel(nullptr)
+    , m_levelLoader(new LevelLoader(m_simulation))
+    , m_chunkCache(new LevelChunkCache(&GameWidget::drawTile, m_jobs, this))
+    , m_levelSerial(0)
     , m_activeRiddle(nullptr)
-    , m_activeEnemy(nullptr)
-    , m_gameTimer(new QTimer(this))
+    , m_runDustTimer(0.0f)
+    , m_replayMode(ReplayMode::NONE)
+    , m_tick(0)
+    , m_playbackCursor(0)
+    , m_playbackEnd(0)
+    , m_openMessages(0)
+    , m_respawnDelay(0.0f)
+    , m_useSoftwareRenderer(qgetenv("DEATHRIDDLE_RENDERER") == "software")
+    , m_gameTimer(new QTimer(m_simulation))
     , m_lastFrameTime(0)
     , m_gamePaused(false)
     , m_riddleActive(false)
     , m_showRetryScreen(false)
     , m_showVictoryScreen(false)
+    , m_transitionPhase(TransitionPhase::NONE)
+    , m_transitionTime(0.0f)
+    , m_nextLevelNumber(0)
     , m_highestScore(0)
     , m_hasKey(false)
     , m_topDownMode(false)
 {
     setFocusPolicy(Qt::StrongFocus);
-    setMinimumSize(960, 640);
+    setMinimumSize(LOGICAL_WIDTH, LOGICAL_HEIGHT);
+    setAttribute(Qt::WA_OpaquePaintEvent);  // presentScene covers every pixel
     
     setupGame();
     
-    // Setup game timer
-    connect(m_gameTimer, &QTimer::timeout, this, &GameWidget::update);
+    // Setup game timer; it fires on whichever thread m_simulation lives on
+    m_simulationThread.setObjectName("Simulation");
+    connect(m_gameTimer, &QTimer::timeout, m_simulation, [this]() { tick(); });
     m_gameTimer->setInterval(1000 / TARGET_FPS);
     
     // Create riddles
@@ -65,6 +85,32 @@ GameWidget::GameWidget(QWidget* parent)
     m_riddles[4]->setHint("Look at the first and last letters of the words...");
 }
 
+GameWidget::~GameWidget() {
+    // Bring the simulation back to this thread, with its timer stopped, so
+    // it can be torn down here
+    if (m_simulationThread.isRunning()) {
+        QThread* home = thread();
+        QMetaObject::invokeMethod(m_simulation, [this, home]() {
+            m_gameTimer->stop();
+            m_simulation->moveToThread(home);
+        }, Qt::BlockingQueuedConnection);
+        m_simulationThread.quit();
+        m_simulationThread.wait();
+    }
+    
+    // Child objects are deleted after our members, but the chunk cache's
+    // jobs run on m_jobs and must be finished first
+    delete m_chunkCache;
+    m_chunkCache = nullptr;
+    
+    // Playback runs until this tick, past the last input
+    m_recording.endRecording(m_tick);
+    
+    // Levels, the level loader and the timer
+    delete m_simulation;
+    m_currentLevel = nullptr;
+}
+
 void GameWidget::setupGame() {
     // Create UI labels
     m_healthLabel = new QLabel("HP: 100", this);
@@ -98,34 +144,70 @@ void GameWidget::setupGame() {
         m_livesLabel->setText(QString("Lives: %1").arg(lives));
     });
     
+    // The labels above update on the GUI thread; the handlers below change
+    // the world, so they run right away on the simulation thread
+    
+    // Dust under the player's feet
+    connect(m_player, &Player2D::landed, this, [this]() {
+        QRectF box = m_player->boundingBox();
+        m_particles.spawn(ParticleSystem::Kind::LAND_DUST, QPointF(box.center().x(), box.bottom() - 16), QPointF());
+    }, Qt::DirectConnection);
+    
+    connect(m_player, &Player2D::doubleJumped, this, [this]() {
+        QRectF box = m_player->boundingBox();
+        m_particles.spawn(ParticleSystem::Kind::JUMP_DUST, QPointF(box.center().x(), box.bottom()), QPointF());
+    }, Qt::DirectConnection);
+    
     connect(m_player, &Player2D::died, this, [this]() {
         if (m_player->lives() > 0) {
-            QTimer::singleShot(1000, this, [this]() {
-                m_player->respawn(m_currentLevel->spawnPoint());
-            });
+            // Counted down in step() so replays respawn on the same tick
+            m_respawnDelay = RESPAWN_DELAY;
         } else {
             // Update highest score
             if (m_player->score() > m_highestScore) {
                 m_highestScore = m_player->score();
             }
             
-            // Show retry screen
+            // Show retry screen (published at the end of this tick)
             pauseGame();
             m_showRetryScreen = true;
-            QWidget::update();  // Force repaint to show retry screen
         }
-    });
+    }, Qt::DirectConnection);
 }
 
 void GameWidget::startGame() {
+    if (!m_headless) {
+        if (!m_simulationThread.isRunning()) {
+            m_simulation->moveToThread(&m_simulationThread);
+            m_simulationThread.start();
+        }
+        setFocus();
+    }
+    simulate([this]() { resetGame(); });
+}
+
+void GameWidget::resetGame() {
+    // DEATHRIDDLE_RECORD=<file> records this session for headless capture
+    if (m_replayMode == ReplayMode::NONE && qEnvironmentVariableIsSet("DEATHRIDDLE_RECORD")) {
+        if (m_recording.beginRecording(qEnvironmentVariable("DEATHRIDDLE_RECORD"))) {
+            m_replayMode = ReplayMode::RECORDING;
+            m_tick = 0;
+        }
+    }
+    
     m_player->respawn(QPointF(64, 500));
     m_player->addScore(-m_player->score());  // Reset score
+    m_transitionPhase = TransitionPhase::NONE;
+    m_respawnDelay = 0.0f;
     loadLevel(1);
-    m_gameTimer->start();
     m_elapsedTimer.start();
     m_lastFrameTime = 0;
     m_gamePaused = false;
-    setFocus();
+    
+    // Playback is stepped by the caller, not the timer
+    if (m_replayMode != ReplayMode::PLAYING) {
+        m_gameTimer->start();
+    }
 }
 
 void GameWidget::pauseGame() {
@@ -150,16 +232,23 @@ void GameWidget::resumeGame() {
     // Restart elapsed timer and reset last frame time to prevent huge delta time spike
     m_elapsedTimer.restart();
     m_lastFrameTime = 0;
-    m_gameTimer->start();
-}
-
-void GameWidget::resetGame() {
-    startGame();
+    if (m_replayMode != ReplayMode::PLAYING) {
+        m_gameTimer->start();
+    }
 }
 
 void GameWidget::loadLevel(int levelNumber) {
+    // Use the level built in the background if it is ready
+    Level* level = m_levelLoader->take(levelNumber);
+    if (!level) {
+        level = new Level(levelNumber);
+    }
+    level->setParent(m_simulation);
+    
     if (m_currentLevel) {
-        delete m_currentLevel;
+        // May be called from one of the old level's signals
+        m_currentLevel->disconnect(this);
+        m_currentLevel->deleteLater();
     }
     
     // Reset key status and set top-down mode for Level 6
@@ -170,31 +259,110 @@ void GameWidget::loadLevel(int levelNumber) {
         m_topDownMode = false;
     }
     
-    m_currentLevel = new Level(levelNumber, this);
-    m_levelLabel->setText(QString("Level %1: %2").arg(levelNumber).arg(m_currentLevel->name()));
+    m_currentLevel = level;
+    m_levelSerial++;
+    
+    // The chunk cache lives on the GUI thread and works from a copy
+    LevelChunkCache::Snapshot tiles = LevelChunkCache::capture(m_currentLevel, m_levelSerial);
+    onGuiThread([this, tiles]() { m_chunkCache->rebuild(tiles); });
+    
+    // Enemies and platforms of the previous level go, this level's are spawned fresh
+    EnemySystem::clear(m_entities);
+    PlatformSystem::clear(m_entities);
+    m_activeEnemy = Entity();
+    m_behaviours.clear();
+    for (const EnemySpawn& spawn : m_currentLevel->enemySpawns()) {
+        // A script that fails to assemble falls back to the type's default
+        int program = spawn.behaviour ? m_behaviours.load(QString::fromUtf8(spawn.behaviour)) : -1;
+        if (program < 0) {
+            program = m_behaviours.load(EnemySystem::defaultBehaviour(spawn.type));
+        }
+        EnemySystem::spawn(m_entities, spawn.type, spawn.position, spawn.riddleId, program);
+    }
+    for (const PlatformSpawn& spawn : m_currentLevel->platformSpawns()) {
+        PlatformSystem::spawn(m_entities, spawn.box, spawn.waypoints, spawn.speed);
+    }
+    m_entities.syncColliders();
+    m_particles.clear();
+    m_projectiles.clear();
+    
+    m_lightMap.reset(m_currentLevel);  // Only dark levels keep a light map
+    
+    // Fog of war only in the maze
+    if (m_topDownMode) {
+        m_fieldOfView.reset(m_currentLevel->width(), m_currentLevel->height());
+    } else {
+        m_fieldOfView.reset(0, 0);
+    }
+    setLabelText(m_levelLabel, QString("Level %1: %2").arg(levelNumber).arg(m_currentLevel->name()));
     m_player->setPosition(m_currentLevel->spawnPoint());
     
-    // Connect level signals
-    connect(m_currentLevel, &Level::riddleTriggered, this, &GameWidget::showRiddle);
+    // Connect level signals; they fire mid-step on the simulation thread
+    // Only the chunk holding a changed tile is re-rendered
+    connect(m_currentLevel, &Level::tileChanged, this, [this](int x, int y) {
+        int index = LevelChunkCache::chunkForColumn(x);
+        QVector<Tile> tiles = LevelChunkCache::captureChunk(m_currentLevel, index);
+        int serial = m_levelSerial;
+        onGuiThread([this, serial, index, tiles]() { m_chunkCache->invalidate(serial, index, tiles); });
+        
+        const Tile* tile = m_currentLevel->getTileAt(x, y);
+        if (tile && tile->type == TileType::BREAKABLE && tile->collected) {
+            m_particles.burst(ParticleSystem::Kind::DEBRIS, tile->boundingBox.center(), 24, 140.0f);
+        }
+    }, Qt::DirectConnection);
+    connect(m_currentLevel, &Level::riddleTriggered, this, [this](int riddleId) {
+        showRiddle(riddleId, Entity());
+    }, Qt::DirectConnection);
     connect(m_currentLevel, &Level::levelComplete, this, [this]() {
-        pauseGame();
+        if (m_transitionPhase != TransitionPhase::NONE) {
+            return;
+        }
         
         if (m_currentLevel->levelNumber() < 6) {
-            QMessageBox::information(this, "Level Complete!", 
-                QString("You completed %1!\n\nScore: %2").arg(m_currentLevel->name()).arg(m_player->score()));
-            loadLevel(m_currentLevel->levelNumber() + 1);
-            resumeGame();
+            beginLevelTransition(m_currentLevel->levelNumber() + 1);
         } else {
+            pauseGame();
             // Game complete - show victory screen
             m_showVictoryScreen = true;
-            update();
         }
-    });
+    }, Qt::DirectConnection);
+    
+    // Start building the next level while this one is played
+    if (levelNumber < 6) {
+        m_levelLoader->prefetch(levelNumber + 1);
+    }
 }
 
-void GameWidget::update() {
-    if (m_gamePaused || m_riddleActive || m_showVictoryScreen) {
-        QWidget::update();
+void GameWidget::beginLevelTransition(int nextLevelNumber) {
+    m_transitionPhase = TransitionPhase::FADE_OUT;
+    m_transitionTime = 0.0f;
+    m_nextLevelNumber = nextLevelNumber;
+    
+    // Freeze the player while the screen fades
+    m_pressedKeys.clear();
+    m_player->setVelocity(QPointF(0, 0));
+}
+
+void GameWidget::updateTransition(float deltaTime) {
+    m_transitionTime += deltaTime;
+    if (m_transitionTime < TRANSITION_DURATION) {
+        return;
+    }
+    
+    if (m_transitionPhase == TransitionPhase::FADE_OUT) {
+        // Screen is fully dark - swap levels and fade back in
+        loadLevel(m_nextLevelNumber);
+        m_transitionPhase = TransitionPhase::FADE_IN;
+        m_transitionTime = 0.0f;
+    } else {
+        m_transitionPhase = TransitionPhase::NONE;
+    }
+}
+
+void GameWidget::tick() {
+    // The world stays frozen while a message box is open, and the frozen
+    // time is not counted in ticks (playback shows no boxes)
+    if (m_openMessages > 0) {
         return;
     }
     
@@ -206,36 +374,71 @@ void GameWidget::update() {
     // Clamp delta time
     if (deltaTime > 0.1f) deltaTime = 0.1f;
     
+    // Recordings run on a fixed timestep so they play back identically
+    if (m_replayMode == ReplayMode::RECORDING) {
+        deltaTime = FIXED_TIMESTEP;
+    }
+    
+    step(deltaTime);
+    m_tick++;
+    
+    publishFrame();
+    onGuiThread([this]() { QWidget::update(); });
+}
+
+void GameWidget::step(float deltaTime) {
+    if (m_gamePaused || m_riddleActive || m_showVictoryScreen) {
+        return;
+    }
+    
+    // Keep the frame loop running during level transitions, but freeze the world
+    if (m_transitionPhase != TransitionPhase::NONE) {
+        updateTransition(deltaTime);
+        return;
+    }
+    
+    // Delayed respawn after losing a life
+    if (m_respawnDelay > 0.0f) {
+        m_respawnDelay -= deltaTime;
+        if (m_respawnDelay <= 0.0f) {
+            m_player->respawn(m_currentLevel->spawnPoint());
+        }
+    }
+    
+    // Platforms move first and take their riders along
+    PlatformSystem::update(m_entities, deltaTime);
+    m_entities.syncColliders();
+    m_player->setPosition(m_player->position() + PlatformSystem::carryDelta(m_entities, m_player->boundingBox()));
+    
     handleInput();
     updatePhysics(deltaTime);
     checkCollisions();
     checkTileInteractions();
     checkEnemyCollisions();
     
-    // Update enemies
-    if (m_currentLevel) {
-        for (Enemy* enemy : m_currentLevel->enemies()) {
-            if (enemy && !enemy->isDead()) {
-                enemy->update(deltaTime);
-            }
-        }
-        
-        // Remove dead enemies after their death animation finishes
-        m_currentLevel->enemies().erase(
-            std::remove_if(m_currentLevel->enemies().begin(), m_currentLevel->enemies().end(),
-                [](Enemy* enemy) {
-                    if (enemy && enemy->isDead() && enemy->isDeathAnimationFinished()) {
-                        qDebug() << "Removing dead enemy after animation finished";
-                        delete enemy;
-                        return true;
-                    }
-                    return false;
-                }),
-            m_currentLevel->enemies().end()
-        );
+    // Enemy perception for this tick's share of enemies, then behaviour at each
+    // enemy's level of detail (far from the camera: less often, or not at all),
+    // projectiles, and every sprite's animation in one pass
+    m_aiScheduler.run(m_entities, *m_currentLevel, m_player->boundingBox().center());
+    QRectF camera(cameraLeft(), 0, LOGICAL_WIDTH, LOGICAL_HEIGHT);
+    m_enemies.update(m_entities, m_behaviours,
+                     { *m_currentLevel, m_player->boundingBox().center(), deltaTime, camera, m_tick },
+                     m_projectiles, m_jobs);
+    updateProjectiles(deltaTime);
+    m_entities.updateAnimations(deltaTime, m_jobs);
+    
+    // Drop dead enemies once their death animation finishes
+    EnemySystem::releaseFinished(m_entities);
+    
+    m_currentLevel->updateBreakables(deltaTime, m_player->boundingBox());
+    updateParticles(deltaTime);
+    
+    // Both are cheap unless the player stepped into another cell
+    QPoint cell = playerCell();
+    if (m_fieldOfView.isEnabled()) {
+        m_fieldOfView.update(*m_currentLevel, cell, FOV_RADIUS);
     }
-    
-    QWidget::update();
+    m_lightMap.setPlayerCell(cell);
 }
 
 void GameWidget::handleInput() {
@@ -290,6 +493,13 @@ void GameWidget::handleInput() {
         if (jumping) {
             m_player->jump();
         }
+        
+        // Held F keeps throwing at the player's own cooldown
+        if (m_pressedKeys.contains(Qt::Key_F) && m_player->tryThrow()) {
+            float direction = m_player->isFacingRight() ? 1.0f : -1.0f;
+            QPointF velocity(direction * THROW_SPEED + m_player->velocity().x() * 0.5f, -THROW_SPEED * 0.35f);
+            m_projectiles.spawn(ProjectileSystem::Owner::PLAYER, m_player->boundingBox().center(), velocity);
+        }
     }
 }
 
@@ -305,24 +515,35 @@ void GameWidget::updatePhysics(float deltaTime) {
 
 void GameWidget::checkCollisions() {
     QRectF playerBox = m_player->boundingBox();
-    QVector<Tile*> nearbyTiles = m_currentLevel->getTilesInArea(playerBox.adjusted(-10, -10, 10, 10));
+    
+    // Solid tiles around the player, plus moving platforms from the collider tree
+    struct Solid {
+        QRectF box;
+        Tile* tile;  // nullptr for platforms
+    };
+    QVarLengthArray<Solid, 32> solids;
+    m_currentLevel->forEachInArea(playerBox.adjusted(-10, -10, 10, 10), Level::SOLID_TILES, [&solids](Tile* tile) {
+        solids.append({ tile->boundingBox, tile });
+    });
+    m_entities.queryColliders(playerBox, [this, &solids](Entity entity) {
+        if (m_entities.has(entity, EntityStore::PLATFORM)) {
+            solids.append({ m_entities.boundingBox(entity), nullptr });
+        }
+    });
     
     bool onGround = false;
     
-    for (Tile* tile : nearbyTiles) {
-        if (tile->type != TileType::SOLID && tile->type != TileType::MOVING_PLATFORM) {
-            continue;
-        }
-        
-        if (!playerBox.intersects(tile->boundingBox)) {
+    for (const Solid& hit : solids) {
+        const QRectF& solid = hit.box;
+        if (!playerBox.intersects(solid)) {
             continue;
         }
         
         // Calculate overlap
-        float overlapLeft = playerBox.right() - tile->boundingBox.left();
-        float overlapRight = tile->boundingBox.right() - playerBox.left();
-        float overlapTop = playerBox.bottom() - tile->boundingBox.top();
-        float overlapBottom = tile->boundingBox.bottom() - playerBox.top();
+        float overlapLeft = playerBox.right() - solid.left();
+        float overlapRight = solid.right() - playerBox.left();
+        float overlapTop = playerBox.bottom() - solid.top();
+        float overlapBottom = solid.bottom() - playerBox.top();
         
         float minOverlap = std::min({overlapLeft, overlapRight, overlapTop, overlapBottom});
         
@@ -332,36 +553,38 @@ void GameWidget::checkCollisions() {
         if (m_topDownMode) {
             // Top-down collision - treat all walls equally
             if (minOverlap == overlapTop) {
-                pos.setY(tile->boundingBox.top() - Player2D::HEIGHT);
+                pos.setY(solid.top() - Player2D::HEIGHT);
                 vel.setY(0);
             } else if (minOverlap == overlapBottom) {
-                pos.setY(tile->boundingBox.bottom());
+                pos.setY(solid.bottom());
                 vel.setY(0);
             } else if (minOverlap == overlapLeft) {
-                pos.setX(tile->boundingBox.left() - Player2D::WIDTH);
+                pos.setX(solid.left() - Player2D::WIDTH);
                 vel.setX(0);
             } else if (minOverlap == overlapRight) {
-                pos.setX(tile->boundingBox.right());
+                pos.setX(solid.right());
                 vel.setX(0);
             }
         } else {
             // Platformer collision - different behavior for top/bottom vs sides
             if (minOverlap == overlapTop && vel.y() > 0) {
                 // Collision from top (landing on platform)
-                pos.setY(tile->boundingBox.top() - Player2D::HEIGHT);
+                pos.setY(solid.top() - Player2D::HEIGHT);
                 vel.setY(0);
                 onGround = true;
+                m_currentLevel->crumbleTile(hit.tile);
             } else if (minOverlap == overlapBottom && vel.y() < 0) {
                 // Collision from bottom (hitting ceiling)
-                pos.setY(tile->boundingBox.bottom());
+                pos.setY(solid.bottom());
                 vel.setY(0);
+                m_currentLevel->breakTile(hit.tile);
             } else if (minOverlap == overlapLeft) {
                 // Collision from left
-                pos.setX(tile->boundingBox.left() - Player2D::WIDTH);
+                pos.setX(solid.left() - Player2D::WIDTH);
                 vel.setX(0);
             } else if (minOverlap == overlapRight) {
                 // Collision from right
-                pos.setX(tile->boundingBox.right());
+                pos.setX(solid.right());
                 vel.setX(0);
             }
         }
@@ -378,25 +601,30 @@ void GameWidget::checkCollisions() {
 
 void GameWidget::checkTileInteractions() {
     QRectF playerBox = m_player->boundingBox();
-    QVector<Tile*> tiles = m_currentLevel->getTilesInArea(playerBox);
+    
+    // Only the tiles that do something when touched; on most ticks there are none
+    QVarLengthArray<Tile*, 8> tiles;
+    m_currentLevel->forEachInArea(playerBox, Level::HAZARD_TILES | Level::COLLECTIBLE_TILES | Level::TRIGGER_TILES,
+                                  [&tiles](Tile* tile) { tiles.append(tile); });
     
     for (Tile* tile : tiles) {
-        if (!playerBox.intersects(tile->boundingBox)) continue;
-        
         switch (tile->type) {
             case TileType::COIN:
                 if (!tile->collected) {
                     m_currentLevel->collectCoin(tile);
                     m_player->collectCoin();
+                    m_particles.burst(ParticleSystem::Kind::COIN_SPARK, tile->boundingBox.center(), 48, 160.0f);
+                    m_lightMap.tileChanged(tile->gridPos.x(), tile->gridPos.y());
                 }
                 break;
             
             case TileType::KEY:
                 if (!tile->collected) {
                     tile->collected = true;
+                    m_lightMap.tileChanged(tile->gridPos.x(), tile->gridPos.y());
                     m_hasKey = true;
                     m_player->addScore(1000);
-                    QMessageBox::information(this, "Key Found!", 
+                    showMessage(false, "Key Found!", 
                         "You found the key! Now you can reach the goal!\n\n+1000 points");
                 }
                 break;
@@ -413,7 +641,7 @@ void GameWidget::checkTileInteractions() {
             case TileType::GOAL:
                 // Check if player has key for Level 6
                 if (m_currentLevel && m_currentLevel->levelNumber() == 6 && !m_hasKey) {
-                    QMessageBox::warning(this, "Locked!", 
+                    showMessage(true, "Locked!", 
                         "You need to find the key first!");
                 } else {
                     m_currentLevel->setComplete(true);
@@ -422,7 +650,10 @@ void GameWidget::checkTileInteractions() {
                 break;
                 
             case TileType::CHECKPOINT:
-                m_currentLevel->activateCheckpoint(tile);
+                if (!tile->activated) {
+                    m_currentLevel->activateCheckpoint(tile);
+                    m_lightMap.tileChanged(tile->gridPos.x(), tile->gridPos.y());
+                }
                 break;
                 
             default:
@@ -436,21 +667,26 @@ void GameWidget::checkEnemyCollisions() {
     
     QRectF playerBox = m_player->boundingBox();
     
-    for (Enemy* enemy : m_currentLevel->enemies()) {
-        if (!enemy || enemy->isDead() || enemy->isRiddleTriggered()) continue;
+    Entity hit;
+    m_entities.queryColliders(playerBox, [this, &playerBox, &hit](Entity enemy) {
+        if (!hit.isNull() || !m_entities.has(enemy, EntityStore::ENEMY)) return;
+        const EnemyComponent& data = m_entities.enemy(enemy);
+        if (data.state == EnemyState::DEAD || data.riddleTriggered) return;
         
-        QRectF enemyBox = enemy->boundingBox();
-        if (playerBox.intersects(enemyBox)) {
-            // Mark enemy riddle as triggered to prevent re-trigger
-            enemy->setRiddleTriggered(true);
-            // Trigger riddle for this enemy
-            showRiddle(enemy->riddleId(), enemy);
-            break;  // Only trigger one riddle at a time
+        if (playerBox.intersects(m_entities.boundingBox(enemy))) {
+            hit = enemy;  // Only trigger one riddle at a time
         }
+    });
+    
+    if (!hit.isNull()) {
+        // Mark enemy riddle as triggered to prevent re-trigger
+        m_entities.enemy(hit).riddleTriggered = true;
+        // Trigger riddle for this enemy
+        showRiddle(m_entities.enemy(hit).riddleId, hit);
     }
 }
 
-void GameWidget::showRiddle(int riddleId, Enemy* enemy) {
+void GameWidget::showRiddle(int riddleId, Entity enemy) {
     if (riddleId < 0 || riddleId >= m_riddles.size()) return;
     
     pauseGame();
@@ -465,10 +701,28 @@ void GameWidget::showRiddle(int riddleId, Enemy* enemy) {
     m_activeRiddle = m_riddles[riddleId];
     m_activeEnemy = enemy;
     
-    bool ok;
-    QString answer = QInputDialog::getText(this, "Riddle Challenge", 
-        m_activeRiddle->getQuestion() + "\n\nHint: " + m_activeRiddle->getHint(),
-        QLineEdit::Normal, "", &ok);
+    // The world stays paused until the answer comes back between ticks:
+    // from the dialog, or during playback as a recorded input event
+    if (m_replayMode == ReplayMode::PLAYING) {
+        return;
+    }
+    Riddle* riddle = m_activeRiddle;
+    onGuiThread([this, riddle]() {
+        bool ok = false;
+        QString answer = QInputDialog::getText(this, "Riddle Challenge", 
+            riddle->getQuestion() + "\n\nHint: " + riddle->getHint(),
+            QLineEdit::Normal, "", &ok);
+        simulate([this, ok, answer]() { answerRiddle(ok, answer); });
+    });
+}
+
+void GameWidget::answerRiddle(bool ok, const QString& answer) {
+    if (!m_riddleActive || !m_activeRiddle) {
+        return;
+    }
+    if (m_replayMode == ReplayMode::RECORDING) {
+        m_recording.record({ m_tick, ok ? ReplayEvent::Type::ANSWER : ReplayEvent::Type::CANCEL, 0, answer });
+    }
     
     if (ok) {
         onRiddleSolved(m_activeRiddle->checkAnswerCaseInsensitive(answer));
@@ -485,24 +739,25 @@ void GameWidget::hideRiddle() {
 
 void GameWidget::onRiddleSolved(bool success) {
     if (success) {
-        QMessageBox::information(this, "Correct!", 
+        showMessage(false, "Correct!", 
             "Well done! The Game Master is impressed.\n\n+500 points");
         m_player->addScore(500);
         m_player->heal(25);
         
         // Kill the enemy with death animation
-        if (m_activeEnemy) {
+        if (m_entities.isAlive(m_activeEnemy)) {
             qDebug() << "Triggering enemy death animation";
-            m_activeEnemy->die();
+            EnemySystem::die(m_entities, m_activeEnemy);
+            m_particles.burst(ParticleSystem::Kind::DEATH_SPARK, m_entities.boundingBox(m_activeEnemy).center(), 160, 220.0f);
         }
     } else {
-        QMessageBox::warning(this, "Incorrect!", 
+        showMessage(true, "Incorrect!", 
             "Wrong answer! The Game Master is not pleased.\n\n-25 HP");
         m_player->takeDamage(25);
         
         // Enemy takes damage but doesn't die
-        if (m_activeEnemy) {
-            m_activeEnemy->takeDamage();
+        if (m_entities.isAlive(m_activeEnemy)) {
+            EnemySystem::takeDamage(m_entities, m_activeEnemy);
         }
     }
     
@@ -515,57 +770,271 @@ void GameWidget::onRiddleSolved(bool success) {
     m_player->setVelocity(QPointF(0, m_player->velocity().y()));
     
     // Clear active enemy reference
-    m_activeEnemy = nullptr;
+    m_activeEnemy = Entity();
     
     resumeGame();
 }
 
 void GameWidget::paintEvent(QPaintEvent* event) {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, false);  // Pixelated style
+    presentScene(renderScene());
+}
+
+int GameWidget::cameraLeft() const {
+    return std::max(0, std::min(
+        static_cast<int>(m_player->position().x() - LOGICAL_WIDTH / 2),
+        m_currentLevel->width() * Level::TILE_SIZE - LOGICAL_WIDTH
+    ));
+}
+
+void GameWidget::publishFrame() {
+    // The slot holds an older frame; every field is rewritten. Vectors are
+    // cleared rather than replaced so they keep their capacity.
+    FrameSnapshot& frame = m_frames.back();
+    frame.tick = m_tick;
+    frame.hasLevel = m_currentLevel != nullptr;
+    frame.levelSerial = m_levelSerial;
+    frame.score = m_player->score();
+    frame.highestScore = m_highestScore;
+    frame.transitionPhase = m_transitionPhase;
+    frame.transitionTime = m_transitionTime;
+    frame.showRetryScreen = m_showRetryScreen;
+    frame.showVictoryScreen = m_showVictoryScreen;
+    frame.tiles.clear();
+    frame.platforms.clear();
+    frame.sprites.clear();
+    frame.projectiles.clear();
+    for (ParticleInstances& particles : frame.particles) {
+        particles.centres.clear();
+        particles.frames.clear();
+        particles.flipped.clear();
+    }
+    frame.lit = m_lightMap.isEnabled();
+    frame.shadeMask = frame.lit ? m_lightMap.shadeMask() : QImage();
+    frame.shade = frame.lit ? m_lightMap.shadeLevels() : QVector<quint8>();
+    frame.fogged = m_fieldOfView.isEnabled();
+    frame.fogMask = frame.fogged ? m_fieldOfView.fogMask() : QImage();
     
-    // Background
-    painter.fillRect(rect(), QColor(25, 25, 40));
+    QRectF viewport(0, 0, LOGICAL_WIDTH, LOGICAL_HEIGHT);
+    if (m_currentLevel) {
+        frame.cameraX = cameraLeft();
+        viewport.moveLeft(frame.cameraX);
+        frame.levelNumber = m_currentLevel->levelNumber();
+        frame.levelName = m_currentLevel->name();
+        frame.levelColumns = m_currentLevel->width();
+        frame.levelRows = m_currentLevel->height();
+        frame.firstColumn = std::max(0, frame.cameraX / Level::TILE_SIZE);
+        frame.lastColumn = std::min(m_currentLevel->width() - 1, (frame.cameraX + LOGICAL_WIDTH) / Level::TILE_SIZE);
+        
+        for (int y = 0; y < m_currentLevel->height(); ++y) {
+            for (int x = frame.firstColumn; x <= frame.lastColumn; ++x) {
+                const Tile* tile = m_currentLevel->getTileAt(x, y);
+                if (tile && tile->type != TileType::EMPTY) {
+                    frame.tiles.append(*tile);
+                }
+            }
+        }
+        
+        m_entities.queryColliders(viewport, [this, &frame](Entity entity) {
+            if (m_entities.has(entity, EntityStore::PLATFORM)) {
+                frame.platforms.append(m_entities.boundingBox(entity));
+            }
+        });
+        
+        m_entities.forEach(EntityStore::ENEMY, [this, &frame, &viewport](Entity enemy) {
+            QRectF box = m_entities.boundingBox(enemy);
+            if (box.intersects(viewport) && isInSight(box)) {
+                const AnimationPlayer& animation = m_entities.animation(enemy);
+                frame.sprites.append({ animation.sheet, animation.currentFrame, box,
+                                       m_entities.isFacingRight(enemy), qRgb(255, 100, 150) });
+            }
+        });
+    } else {
+        frame.cameraX = 0;
+        frame.levelNumber = 0;
+        frame.levelName.clear();
+        frame.levelColumns = frame.levelRows = 0;
+        frame.firstColumn = 0;
+        frame.lastColumn = -1;
+    }
     
-    // Camera offset (center on player)
-    int cameraX = std::max(0, std::min(
-        static_cast<int>(m_player->position().x() - width() / 2),
-        m_currentLevel->width() * Level::TILE_SIZE - width()
-    ));
+    const AnimationPlayer* animation = m_player->getCurrentAnimation();
+    QRgb bodyColor = (m_player->state() == Player2D::State::DEAD) ? qRgb(100, 100, 100) : qRgb(70, 130, 180);
+    frame.sprites.append({ animation ? animation->sheet : nullptr, animation ? animation->currentFrame : 0,
+                           m_player->boundingBox(), m_player->isFacingRight(), bodyColor });
     
-    painter.translate(-cameraX, 0);
+    const ProjectileSystem::Pool& projectiles = m_projectiles.pool();
+    for (int i = 0; i < projectiles.count; ++i) {
+        QPointF centre(projectiles.x[i], projectiles.y[i]);
+        if (viewport.contains(centre)) {
+            frame.projectiles.append(centre);
+        }
+    }
     
-    if (m_currentLevel) {
-        drawLevel(painter);
-        drawEnemies(painter);
+    for (int k = 0; k < ParticleSystem::KIND_COUNT; ++k) {
+        auto kind = static_cast<ParticleSystem::Kind>(k);
+        bool animated = ParticleSystem::info(kind).sheet != nullptr;
+        const ParticleSystem::Pool& pool = m_particles.pool(kind);
+        ParticleInstances& particles = frame.particles[k];
+        for (int i = 0; i < pool.count; ++i) {
+            QPointF centre(pool.x[i], pool.y[i]);
+            if (!viewport.contains(centre)) continue;
+            particles.centres.append(centre);
+            particles.flipped.append(pool.flipped[i]);
+            if (animated) {
+                particles.frames.append(m_particles.frameOf(kind, i));
+            }
+        }
     }
     
-    drawPlayer(painter);
+    m_frames.publish();
+}
+
+const QImage& GameWidget::renderScene() {
+    // The newest published tick; with nothing new the last one is drawn again
+    m_frames.acquire();
+    const FrameSnapshot& frame = m_frames.front();
+    int cameraX = frame.cameraX;
+    
+    // Per-section paint times, read back by the golden-frame check
+    QElapsedTimer sectionTimer;
+    sectionTimer.start();
+    m_paintTimings = PaintTimings();
+    
+    // The scene is always drawn at the fixed logical resolution, whatever the
+    // size of the display, and upscaled once at the end
+    QImage* scene;
+    if (m_useSoftwareRenderer) {
+        // Whole scene composed in memory by the SIMD blitter
+        renderSoftware(frame, sectionTimer);
+        scene = &m_softwareRenderer.frame();
+    } else {
+        if (m_sceneBuffer.isNull()) {
+            m_sceneBuffer = QImage(LOGICAL_WIDTH, LOGICAL_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+        }
+        scene = &m_sceneBuffer;
+    }
     
-    painter.translate(cameraX, 0);
+    QPainter painter(scene);
+    painter.setRenderHint(QPainter::Antialiasing, false);  // Pixelated style
+    
+    if (!m_useSoftwareRenderer) {
+        // Background
+        painter.fillRect(sceneRect(), QColor(25, 25, 40));
+        
+        painter.translate(-cameraX, 0);
+        
+        if (frame.hasLevel) {
+            drawLevel(painter, frame);
+            m_paintTimings.levelNs = sectionTimer.nsecsElapsed();
+        }
+        
+        drawSprites(painter, frame);
+        drawProjectiles(frame);
+        drawParticles(frame);
+        
+        // Sprites queued above go out in one call per sheet, then the square
+        // particles (sparks) on top of the sprites they fly off
+        m_spriteBatch.flush(painter);
+        drawParticleRects(painter, frame);
+        m_paintTimings.spritesNs = sectionTimer.nsecsElapsed() - m_paintTimings.levelNs;
+        
+        drawLighting(painter, frame);
+        drawFog(painter, frame);
+        
+        painter.translate(cameraX, 0);
+    }
     
     // UI is always on screen
     drawUI(painter);
     
+    if (frame.transitionPhase != TransitionPhase::NONE) {
+        drawTransition(painter, frame);
+    }
+    
     // Victory screen (drawn last, over everything)
-    if (m_showVictoryScreen) {
-        drawVictoryScreen(painter);
+    if (frame.showVictoryScreen) {
+        drawOverlay(painter, m_victoryOverlay, frame, &GameWidget::drawVictoryScreen);
     }
     // Retry screen (drawn last, over everything)
-    else if (m_showRetryScreen) {
-        drawRetryScreen(painter);
+    else if (frame.showRetryScreen) {
+        drawOverlay(painter, m_retryOverlay, frame, &GameWidget::drawRetryScreen);
     }
+    
+    painter.end();
+    m_paintTimings.totalNs = sectionTimer.nsecsElapsed();
+    m_paintTimings.overlaysNs = m_paintTimings.totalNs - m_paintTimings.levelNs - m_paintTimings.spritesNs;
+    return *scene;
 }
 
-void GameWidget::drawLevel(QPainter& painter) {
-    for (int y = 0; y < m_currentLevel->height(); ++y) {
-        for (int x = 0; x < m_currentLevel->width(); ++x) {
-            const Tile* tile = m_currentLevel->getTileAt(x, y);
-            if (tile && tile->type != TileType::EMPTY) {
-                drawTile(painter, tile);
-            }
+void GameWidget::presentScene(const QImage& scene) {
+    QPainter painter(this);
+    
+    // Largest whole-number scale that fits, centred, nearest-neighbour
+    int scale = std::max(1, std::min(width() / LOGICAL_WIDTH, height() / LOGICAL_HEIGHT));
+    QRect target(0, 0, LOGICAL_WIDTH * scale, LOGICAL_HEIGHT * scale);
+    target.moveCenter(rect().center());
+    
+    // Letterbox bars around the scaled scene
+    QColor barColor(0, 0, 0);
+    painter.fillRect(QRect(0, 0, width(), target.top()), barColor);
+    painter.fillRect(QRect(0, target.bottom() + 1, width(), height() - target.bottom() - 1), barColor);
+    painter.fillRect(QRect(0, target.top(), target.left(), target.height()), barColor);
+    painter.fillRect(QRect(target.right() + 1, target.top(), width() - target.right() - 1, target.height()), barColor);
+    
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter.drawImage(target, scene);
+}
+
+void GameWidget::drawLevel(QPainter& painter, const FrameSnapshot& frame) {
+    // Walls and spikes come from the pre-rendered chunks where available
+    for (int index = LevelChunkCache::chunkForColumn(frame.firstColumn); index <= LevelChunkCache::chunkForColumn(frame.lastColumn); ++index) {
+        if (const QImage* chunk = levelChunk(frame, index)) {
+            painter.drawImage(LevelChunkCache::chunkOrigin(index), *chunk);
+        }
+    }
+    
+    // The snapshot only holds the visible columns
+    for (const Tile& tile : frame.tiles) {
+        if (LevelChunkCache::isStatic(tile) && levelChunk(frame, LevelChunkCache::chunkForColumn(tile.gridPos.x()))) {
+            continue;  // Already in the chunk image
         }
+        drawTile(painter, &tile);
     }
+    
+    drawPlatforms(painter, frame);
+}
+
+const QImage* GameWidget::levelChunk(const FrameSnapshot& frame, int index) const {
+    // A frame can arrive before the cache has been handed its level
+    if (m_chunkCache->serial() != frame.levelSerial) {
+        return nullptr;
+    }
+    return m_chunkCache->chunk(index);
+}
+
+void GameWidget::drawPlatforms(QPainter& painter, const FrameSnapshot& frame) {
+    painter.setPen(QColor(90, 60, 30));
+    for (const QRectF& box : frame.platforms) {
+        painter.fillRect(box, QColor(150, 105, 60));
+        painter.drawRect(box);
+    }
+}
+
+// Font for the riddle and goal tile glyphs, built once rather than per tile
+static const QFont& tileGlyphFont() {
+    static const QFont font = [] {
+        QFont f;
+        f.setPointSize(20);
+        return f;
+    }();
+    return font;
+}
+
+// Glyph text with its layout cached, so tiles skip text shaping every frame
+static QStaticText tileGlyph(const QString& text) {
+    QStaticText glyph(text);
+    glyph.prepare(QTransform(), tileGlyphFont());
+    return glyph;
 }
 
 void GameWidget::drawTile(QPainter& painter, const Tile* tile) {
@@ -601,11 +1070,10 @@ void GameWidget::drawTile(QPainter& painter, const Tile* tile) {
         case TileType::RIDDLE_TRIGGER: {
             if (!tile->activated) {
                 painter.fillRect(rect, QColor(150, 50, 200));
+                static const QStaticText glyph = tileGlyph("?");
                 painter.setPen(Qt::white);
-                QFont font = painter.font();
-                font.setPointSize(20);
-                painter.setFont(font);
-                painter.drawText(rect, Qt::AlignCenter, "?");
+                painter.setFont(tileGlyphFont());
+                painter.drawStaticText(rect.center() - QPointF(glyph.size().width(), glyph.size().height()) / 2, glyph);
             }
             break;
         }
@@ -624,14 +1092,39 @@ void GameWidget::drawTile(QPainter& painter, const Tile* tile) {
             
         case TileType::GOAL: {
             painter.fillRect(rect, QColor(50, 255, 50));
+            static const QStaticText glyph = tileGlyph("★");
             painter.setPen(Qt::white);
-            QFont font = painter.font();
-            font.setPointSize(20);
-            painter.setFont(font);
-            painter.drawText(rect, Qt::AlignCenter, "★");
+            painter.setFont(tileGlyphFont());
+            painter.drawStaticText(rect.center() - QPointF(glyph.size().width(), glyph.size().height()) / 2, glyph);
+            break;
+        }
+            
+        case TileType::TORCH: {
+            // Bracket and flame
+            painter.fillRect(QRectF(rect.center().x() - 2, rect.center().y() - 2, 4, 12), QColor(110, 70, 30));
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(QColor(255, 160, 40));
+            painter.drawEllipse(QPointF(rect.center().x(), rect.center().y() - 6), 5, 7);
+            painter.setBrush(QColor(255, 230, 120));
+            painter.drawEllipse(QPointF(rect.center().x(), rect.center().y() - 5), 2, 4);
             break;
         }
             
+        case TileType::BREAKABLE:
+            if (!tile->collected) {
+                // Cracked stone; crumbling blocks show deeper cracks
+                painter.fillRect(rect, tile->activated ? QColor(125, 95, 65) : QColor(140, 110, 80));
+                painter.setPen(QColor(90, 65, 40));
+                painter.drawRect(rect);
+                painter.drawLine(QPointF(rect.left() + 8, rect.top()), QPointF(rect.left() + 14, rect.top() + 12));
+                painter.drawLine(QPointF(rect.left() + 14, rect.top() + 12), QPointF(rect.left() + 10, rect.bottom()));
+                if (tile->activated) {
+                    painter.drawLine(QPointF(rect.right(), rect.top() + 10), QPointF(rect.left() + 14, rect.top() + 12));
+                    painter.drawLine(QPointF(rect.left() + 14, rect.top() + 12), QPointF(rect.right() - 6, rect.bottom()));
+                }
+            }
+            break;
+            
         case TileType::CHECKPOINT: {
             painter.fillRect(rect, QColor(100, 150, 255));
             if (tile->activated) {
@@ -645,79 +1138,310 @@ void GameWidget::drawTile(QPainter& painter, const Tile* tile) {
     }
 }
 
-void GameWidget::drawPlayer(QPainter& painter) {
-    AnimatedSprite* sprite = m_player->getCurrentSprite();
-    if (!sprite) {
-        // Fallback to simple rectangle if no sprite loaded
-        QRectF box = m_player->boundingBox();
-        QColor bodyColor(70, 130, 180);
-        if (m_player->state() == Player2D::State::DEAD) {
-            bodyColor = QColor(100, 100, 100);
+void GameWidget::drawSprites(QPainter& painter, const FrameSnapshot& frame) {
+    for (const SpriteInstance& sprite : frame.sprites) {
+        if (!sprite.sheet) {
+            // Fallback to simple rectangle if no sprite loaded
+            painter.fillRect(sprite.box, QColor(sprite.fallbackColor));
+            continue;
+        }
+        m_spriteBatch.add(sprite.sheet, sprite.frame, sprite.box.topLeft(), sprite.facingRight);
+    }
+}
+
+bool GameWidget::isInSight(const QRectF& box) const {
+    if (!m_fieldOfView.isEnabled()) {
+        return true;
+    }
+    QPointF centre = box.center();
+    return m_fieldOfView.isVisible(static_cast<int>(centre.x()) / Level::TILE_SIZE,
+                                   static_cast<int>(centre.y()) / Level::TILE_SIZE);
+}
+
+QPoint GameWidget::playerCell() const {
+    QPointF centre = m_player->boundingBox().center();
+    return QPoint(static_cast<int>(centre.x()) / Level::TILE_SIZE, static_cast<int>(centre.y()) / Level::TILE_SIZE);
+}
+
+void GameWidget::drawLighting(QPainter& painter, const FrameSnapshot& frame) {
+    if (!frame.lit) return;
+    
+    // The shade mask is one pixel per tile; smooth upscaling turns it into
+    // soft gradients. One draw for the visible columns.
+    int firstColumn = frame.firstColumn;
+    int columns = frame.lastColumn - firstColumn + 1;
+    int rows = frame.levelRows;
+    
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    painter.drawImage(QRectF(firstColumn * Level::TILE_SIZE, 0, columns * Level::TILE_SIZE, rows * Level::TILE_SIZE),
+                      frame.shadeMask, QRectF(firstColumn, 0, columns, rows));
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+}
+
+void GameWidget::drawFog(QPainter& painter, const FrameSnapshot& frame) {
+    if (!frame.fogged) return;
+    
+    // One scaled draw of the visible part of the mask; no smoothing keeps
+    // the fog aligned to tiles
+    int firstColumn = frame.firstColumn;
+    int columns = frame.lastColumn - firstColumn + 1;
+    int rows = frame.levelRows;
+    
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter.drawImage(QRectF(firstColumn * Level::TILE_SIZE, 0, columns * Level::TILE_SIZE, rows * Level::TILE_SIZE),
+                      frame.fogMask, QRectF(firstColumn, 0, columns, rows));
+}
+
+void GameWidget::renderSoftware(const FrameSnapshot& frame, const QElapsedTimer& sectionTimer) {
+    m_softwareRenderer.resize(QSize(LOGICAL_WIDTH, LOGICAL_HEIGHT));
+    m_softwareRenderer.clear(qRgb(25, 25, 40));
+    m_softwareRenderer.setTranslation(QPoint(-frame.cameraX, 0));
+    
+    if (frame.hasLevel) {
+        for (int index = LevelChunkCache::chunkForColumn(frame.firstColumn); index <= LevelChunkCache::chunkForColumn(frame.lastColumn); ++index) {
+            if (const QImage* chunk = levelChunk(frame, index)) {
+                m_softwareRenderer.blit(*chunk, chunk->rect(), LevelChunkCache::chunkOrigin(index));
+            }
+        }
+        
+        for (const Tile& tile : frame.tiles) {
+            if (LevelChunkCache::isStatic(tile) && levelChunk(frame, LevelChunkCache::chunkForColumn(tile.gridPos.x()))) {
+                continue;
+            }
+            if (const QImage* image = tileImage(&tile)) {
+                m_softwareRenderer.blit(*image, image->rect(), tile.boundingBox.topLeft().toPoint());
+            }
+        }
+        
+        for (const QRectF& box : frame.platforms) {
+            m_softwareRenderer.fillRect(box.toRect(), qRgb(150, 105, 60));
         }
-        painter.fillRect(box, bodyColor);
-        return;
     }
+    m_paintTimings.levelNs = sectionTimer.nsecsElapsed();
     
-    QRectF box = m_player->boundingBox();
-    const QPixmap& spriteSheet = sprite->getPixmap();
-    QRect sourceRect = sprite->getCurrentFrame();
+    for (const SpriteInstance& sprite : frame.sprites) {
+        if (!sprite.sheet) {
+            m_softwareRenderer.fillRect(sprite.box.toRect(), sprite.fallbackColor);
+            continue;
+        }
+        m_softwareRenderer.blit(sprite.sheet->premultipliedImage(), sprite.sheet->frameRect(sprite.frame),
+                                sprite.box.topLeft().toPoint(), !sprite.facingRight);
+    }
     
-    // Flip horizontally if facing left
-    if (!m_player->isFacingRight()) {
-        painter.save();
-        painter.translate(box.x() + box.width(), box.y());
-        painter.scale(-1, 1);
-        painter.drawPixmap(QRect(0, 0, box.width(), box.height()), 
-                          spriteSheet, sourceRect);
-        painter.restore();
-    } else {
-        painter.drawPixmap(box.toRect(), spriteSheet, sourceRect);
+    if (const SpriteSheet* rock = ProjectileSystem::sheet()) {
+        QPoint half(rock->frameWidth() / 2, rock->frameHeight() / 2);
+        for (const QPointF& centre : frame.projectiles) {
+            m_softwareRenderer.blit(rock->premultipliedImage(), rock->frameRect(0), centre.toPoint() - half);
+        }
+    }
+    
+    for (int k = 0; k < ParticleSystem::KIND_COUNT; ++k) {
+        const ParticleSystem::KindInfo& info = ParticleSystem::info(static_cast<ParticleSystem::Kind>(k));
+        const ParticleInstances& particles = frame.particles[k];
+        
+        for (int i = 0; i < particles.centres.size(); ++i) {
+            QPointF centre = particles.centres[i];
+            if (info.sheet) {
+                QPoint topLeft = centre.toPoint() - QPoint(info.sheet->frameWidth() / 2, info.sheet->frameHeight() / 2);
+                m_softwareRenderer.blit(info.sheet->premultipliedImage(), info.sheet->frameRect(particles.frames[i]),
+                                        topLeft, particles.flipped[i] != 0);
+            } else {
+                QPoint topLeft = centre.toPoint() - QPoint(info.size / 2, info.size / 2);
+                m_softwareRenderer.fillRect(QRect(topLeft, QSize(info.size, info.size)), info.color);
+            }
+        }
+    }
+    m_paintTimings.spritesNs = sectionTimer.nsecsElapsed() - m_paintTimings.levelNs;
+    
+    if (frame.lit && frame.hasLevel) {
+        // One pre-filled shade tile per light level, blended per visible tile
+        if (m_shadeTiles.isEmpty()) {
+            for (int light = 0; light <= LightMap::MAX_LIGHT; ++light) {
+                QImage shade(Level::TILE_SIZE, Level::TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+                shade.fill(LightMap::shadeFor(light));
+                m_shadeTiles.append(shade);
+            }
+        }
+        
+        for (int y = 0; y < frame.levelRows; ++y) {
+            for (int x = frame.firstColumn; x <= frame.lastColumn; ++x) {
+                int light = frame.shade[y * frame.levelColumns + x];
+                if (light >= LightMap::MAX_LIGHT) continue;
+                const QImage& shade = m_shadeTiles[light];
+                m_softwareRenderer.blit(shade, shade.rect(), QPoint(x * Level::TILE_SIZE, y * Level::TILE_SIZE));
+            }
+        }
+    }
+    
+    if (frame.fogged && frame.hasLevel) {
+        // Same mask as the QPainter path, one tile-sized fill or blend per fogged tile
+        if (m_exploredFogTile.isNull()) {
+            m_exploredFogTile = QImage(Level::TILE_SIZE, Level::TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+            m_exploredFogTile.fill(FieldOfView::EXPLORED_FOG);
+        }
+        
+        for (int y = 0; y < frame.levelRows; ++y) {
+            const QRgb* fog = reinterpret_cast<const QRgb*>(frame.fogMask.constScanLine(y));
+            for (int x = frame.firstColumn; x <= frame.lastColumn; ++x) {
+                QPoint topLeft(x * Level::TILE_SIZE, y * Level::TILE_SIZE);
+                if (fog[x] == FieldOfView::UNEXPLORED_FOG) {
+                    m_softwareRenderer.fillRect(QRect(topLeft, QSize(Level::TILE_SIZE, Level::TILE_SIZE)), FieldOfView::UNEXPLORED_FOG);
+                } else if (fog[x] == FieldOfView::EXPLORED_FOG) {
+                    m_softwareRenderer.blit(m_exploredFogTile, m_exploredFogTile.rect(), topLeft);
+                }
+            }
+        }
     }
 }
 
-void GameWidget::drawEnemies(QPainter& painter) {
-    if (!m_currentLevel) return;
+const QImage* GameWidget::tileImage(const Tile* tile) {
+    // Collected pickups and used triggers draw nothing
+    if ((tile->type == TileType::COIN || tile->type == TileType::KEY) && tile->collected) {
+        return nullptr;
+    }
+    if (tile->type == TileType::RIDDLE_TRIGGER && tile->activated) {
+        return nullptr;
+    }
+    if (tile->type == TileType::BREAKABLE && tile->collected) {
+        return nullptr;
+    }
     
-    for (Enemy* enemy : m_currentLevel->enemies()) {
-        if (enemy) {
-            drawEnemy(painter, enemy);
-        }
+    int key = static_cast<int>(tile->type) * 2 + (tile->activated ? 1 : 0);
+    auto it = m_tileImages.find(key);
+    if (it == m_tileImages.end()) {
+        // Render the tile once with the regular QPainter path
+        QImage image(Level::TILE_SIZE, Level::TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        
+        Tile prototype;
+        prototype.type = tile->type;
+        prototype.activated = tile->activated;
+        prototype.boundingBox = QRectF(0, 0, Level::TILE_SIZE, Level::TILE_SIZE);
+        
+        QPainter painter(&image);
+        drawTile(painter, &prototype);
+        painter.end();
+        
+        it = m_tileImages.insert(key, image);
     }
+    return &it.value();
 }
 
-void GameWidget::drawEnemy(QPainter& painter, Enemy* enemy) {
-    AnimatedSprite* sprite = enemy->getCurrentSprite();
-    if (!sprite) {
-        // Fallback to simple rectangle
-        QRectF box = enemy->boundingBox();
-        painter.fillRect(box, QColor(255, 100, 150));
-        return;
+void GameWidget::updateParticles(float deltaTime) {
+    // Puffs of dust at a steady rate while running on the ground
+    m_runDustTimer -= deltaTime;
+    if (m_player->isOnGround() && std::abs(m_player->velocity().x()) > RUN_DUST_SPEED && m_runDustTimer <= 0.0f) {
+        QRectF box = m_player->boundingBox();
+        bool facingRight = m_player->isFacingRight();
+        QPointF feet(facingRight ? box.left() : box.right(), box.bottom() - 16);
+        m_particles.spawn(ParticleSystem::Kind::RUN_DUST, feet, QPointF(), !facingRight);
+        m_runDustTimer = RUN_DUST_INTERVAL;
     }
     
-    QRectF box = enemy->boundingBox();
-    const QPixmap& spriteSheet = sprite->getPixmap();
-    QRect sourceRect = sprite->getCurrentFrame();
+    m_particles.update(deltaTime, m_jobs);
+}
+
+void GameWidget::updateProjectiles(float deltaTime) {
+    m_projectiles.update(deltaTime, *m_currentLevel);
+    
+    // Rocks that hit the level chip it; breakable blocks give way
+    for (const ProjectileSystem::Impact& impact : m_projectiles.impacts()) {
+        Tile* tile = m_currentLevel->getTileAt(impact.cell.x(), impact.cell.y());
+        if (tile && tile->type == TileType::BREAKABLE) {
+            m_currentLevel->breakTile(tile);
+        } else {
+            m_particles.burst(ParticleSystem::Kind::DEBRIS, impact.position, 4, 60.0f);
+        }
+    }
     
-    // Flip horizontally based on facing direction
-    if (!enemy->isFacingRight()) {
-        painter.save();
-        painter.translate(box.x() + box.width(), box.y());
-        painter.scale(-1, 1);
-        painter.drawPixmap(QRect(0, 0, box.width(), box.height()), 
-                          spriteSheet, sourceRect);
-        painter.restore();
-    } else {
-        painter.drawPixmap(box.toRect(), spriteSheet, sourceRect);
+    // Rocks against creatures: the player's through the collider tree,
+    // the enemies' against the player alone
+    const ProjectileSystem::Pool& pool = m_projectiles.pool();
+    QRectF playerBox = m_player->boundingBox();
+    bool playerAlive = m_player->state() != Player2D::State::DEAD;
+    const qreal half = ProjectileSystem::SIZE / 2.0;
+    for (int i = 0; i < pool.count; ) {
+        QRectF box(pool.x[i] - half, pool.y[i] - half, ProjectileSystem::SIZE, ProjectileSystem::SIZE);
+        bool hit = false;
+        
+        if (static_cast<ProjectileSystem::Owner>(pool.owner[i]) == ProjectileSystem::Owner::PLAYER) {
+            m_entities.queryColliders(box, [this, &box, &hit](Entity enemy) {
+                if (hit || !m_entities.has(enemy, EntityStore::ENEMY) || EnemySystem::isDead(m_entities, enemy)) return;
+                if (box.intersects(m_entities.boundingBox(enemy))) {
+                    EnemySystem::takeDamage(m_entities, enemy);
+                    hit = true;
+                }
+            });
+        } else if (playerAlive && box.intersects(playerBox)) {
+            m_player->takeDamage(PROJECTILE_DAMAGE);
+            playerAlive = m_player->state() != Player2D::State::DEAD;
+            hit = true;
+        }
+        
+        if (hit) {
+            m_particles.burst(ParticleSystem::Kind::DEBRIS, box.center(), 6, 80.0f);
+            m_projectiles.remove(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void GameWidget::drawProjectiles(const FrameSnapshot& frame) {
+    const SpriteSheet* sheet = ProjectileSystem::sheet();
+    if (!sheet) return;
+    
+    QPointF half(sheet->frameWidth() / 2.0, sheet->frameHeight() / 2.0);
+    for (const QPointF& centre : frame.projectiles) {
+        m_spriteBatch.add(sheet, 0, centre - half, true);
+    }
+}
+
+void GameWidget::drawParticles(const FrameSnapshot& frame) {
+    // Sprite kinds join the sprite batch
+    for (int k = 0; k < ParticleSystem::KIND_COUNT; ++k) {
+        const ParticleSystem::KindInfo& info = ParticleSystem::info(static_cast<ParticleSystem::Kind>(k));
+        const ParticleInstances& particles = frame.particles[k];
+        if (!info.sheet) continue;
+        
+        QPointF half(info.sheet->frameWidth() / 2.0, info.sheet->frameHeight() / 2.0);
+        for (int i = 0; i < particles.centres.size(); ++i) {
+            m_spriteBatch.add(info.sheet, particles.frames[i], particles.centres[i] - half, !particles.flipped[i]);
+        }
+    }
+}
+
+void GameWidget::drawParticleRects(QPainter& painter, const FrameSnapshot& frame) {
+    // Square kinds go out as a single drawRects each
+    for (int k = 0; k < ParticleSystem::KIND_COUNT; ++k) {
+        const ParticleSystem::KindInfo& info = ParticleSystem::info(static_cast<ParticleSystem::Kind>(k));
+        const ParticleInstances& particles = frame.particles[k];
+        if (info.sheet || particles.centres.isEmpty()) continue;
+        
+        m_particleRects.clear();
+        qreal half = info.size / 2.0;
+        for (const QPointF& centre : particles.centres) {
+            m_particleRects.append(QRectF(centre.x() - half, centre.y() - half, info.size, info.size));
+        }
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(info.color));
+        painter.drawRects(m_particleRects.constData(), static_cast<int>(m_particleRects.size()));
     }
 }
 
 void GameWidget::drawUI(QPainter& painter) {
-    // UI labels are already QWidgets, they paint themselves
+    // UI labels are already QWidgets, they paint themselves on screen.
+    // Headless playback never shows the widget, so bake them into the frame.
+    if (m_headless) {
+        for (QLabel* label : { m_healthLabel, m_scoreLabel, m_livesLabel, m_levelLabel }) {
+            label->render(&painter, label->pos());
+        }
+    }
 }
 
-void GameWidget::drawRetryScreen(QPainter& painter) {
+void GameWidget::drawRetryScreen(QPainter& painter, const FrameSnapshot& frame) {
     // Semi-transparent dark overlay
-    painter.fillRect(rect(), QColor(0, 0, 0, 200));
+    painter.fillRect(sceneRect(), QColor(0, 0, 0, 200));
     
     // Game Over title
     painter.setPen(QColor(255, 50, 50));
@@ -725,7 +1449,7 @@ void GameWidget::drawRetryScreen(QPainter& painter) {
     titleFont.setPointSize(48);
     titleFont.setBold(true);
     painter.setFont(titleFont);
-    painter.drawText(rect(), Qt::AlignHCenter | Qt::AlignTop, "GAME OVER");
+    painter.drawText(sceneRect(), Qt::AlignHCenter | Qt::AlignTop, "GAME OVER");
     
     // Scores
     painter.setPen(Qt::white);
@@ -733,28 +1457,90 @@ void GameWidget::drawRetryScreen(QPainter& painter) {
     scoreFont.setPointSize(24);
     painter.setFont(scoreFont);
     
-    int centerY = height() / 2 - 50;
-    painter.drawText(QRect(0, centerY, width(), 40), Qt::AlignCenter, 
-                    QString("Current Score: %1").arg(m_player->score()));
-    painter.drawText(QRect(0, centerY + 50, width(), 40), Qt::AlignCenter, 
-                    QString("Highest Score: %1").arg(m_highestScore));
+    int centerY = LOGICAL_HEIGHT / 2 - 50;
+    painter.drawText(QRect(0, centerY, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
+                    QString("Current Score: %1").arg(frame.score));
+    painter.drawText(QRect(0, centerY + 50, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
+                    QString("Highest Score: %1").arg(frame.highestScore));
     
     // Instructions
     QFont instFont;
     instFont.setPointSize(18);
     painter.setFont(instFont);
     painter.setPen(QColor(200, 200, 200));
-    painter.drawText(QRect(0, height() - 100, width(), 40), Qt::AlignCenter, 
+    painter.drawText(QRect(0, LOGICAL_HEIGHT - 100, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
                     "Press R to Retry or ESC to Return to Menu");
 }
 
-void GameWidget::drawVictoryScreen(QPainter& painter) {
+void GameWidget::drawTransition(QPainter& painter, const FrameSnapshot& frame) {
+    float progress = std::min(1.0f, frame.transitionTime / TRANSITION_DURATION);
+    float opacity = (frame.transitionPhase == TransitionPhase::FADE_OUT) ? progress : 1.0f - progress;
+    int alpha = static_cast<int>(opacity * 255);
+    
+    painter.fillRect(sceneRect(), QColor(0, 0, 0, alpha));
+    
+    // Text is rendered once per level and faded by opacity
+    painter.setOpacity(opacity);
+    if (frame.transitionPhase == TransitionPhase::FADE_OUT) {
+        drawOverlay(painter, m_levelCompleteOverlay, frame, &GameWidget::drawLevelCompleteText);
+    } else {
+        drawOverlay(painter, m_levelTitleOverlay, frame, &GameWidget::drawLevelTitleText);
+    }
+    painter.setOpacity(1.0);
+}
+
+void GameWidget::drawLevelCompleteText(QPainter& painter, const FrameSnapshot& frame) {
+    QFont titleFont;
+    titleFont.setPointSize(32);
+    titleFont.setBold(true);
+    painter.setFont(titleFont);
+    painter.setPen(Qt::white);
+    painter.drawText(QRect(0, LOGICAL_HEIGHT / 2 - 60, LOGICAL_WIDTH, 50), Qt::AlignCenter,
+                    QString("You completed %1!").arg(frame.levelName));
+    
+    QFont scoreFont;
+    scoreFont.setPointSize(20);
+    painter.setFont(scoreFont);
+    painter.drawText(QRect(0, LOGICAL_HEIGHT / 2, LOGICAL_WIDTH, 40), Qt::AlignCenter,
+                    QString("Score: %1").arg(frame.score));
+}
+
+void GameWidget::drawLevelTitleText(QPainter& painter, const FrameSnapshot& frame) {
+    QFont titleFont;
+    titleFont.setPointSize(32);
+    titleFont.setBold(true);
+    painter.setFont(titleFont);
+    painter.setPen(Qt::white);
+    painter.drawText(QRect(0, LOGICAL_HEIGHT / 2 - 25, LOGICAL_WIDTH, 50), Qt::AlignCenter,
+                    frame.levelName);
+}
+
+void GameWidget::drawOverlay(QPainter& painter, OverlayLayer& layer, const FrameSnapshot& frame,
+                             void (GameWidget::*paint)(QPainter&, const FrameSnapshot&)) {
+    // Re-render only when something the overlay shows has changed
+    if (layer.image.isNull() || layer.levelNumber != frame.levelNumber ||
+        layer.score != frame.score || layer.highestScore != frame.highestScore) {
+        if (layer.image.isNull()) {
+            layer.image = QImage(LOGICAL_WIDTH, LOGICAL_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+        }
+        layer.image.fill(Qt::transparent);
+        QPainter layerPainter(&layer.image);
+        (this->*paint)(layerPainter, frame);
+        layer.levelNumber = frame.levelNumber;
+        layer.score = frame.score;
+        layer.highestScore = frame.highestScore;
+    }
+    
+    painter.drawImage(0, 0, layer.image);
+}
+
+void GameWidget::drawVictoryScreen(QPainter& painter, const FrameSnapshot& frame) {
     // Victory background with golden gradient
-    QLinearGradient gradient(0, 0, 0, height());
+    QLinearGradient gradient(0, 0, 0, LOGICAL_HEIGHT);
     gradient.setColorAt(0, QColor(255, 215, 0, 230));      // Gold
     gradient.setColorAt(0.5, QColor(255, 140, 0, 230));    // Dark Orange
     gradient.setColorAt(1, QColor(184, 134, 11, 230));     // Dark Golden
-    painter.fillRect(rect(), gradient);
+    painter.fillRect(sceneRect(), gradient);
     
     // Victory title with glow effect
     painter.setPen(QColor(255, 255, 255));
@@ -765,11 +1551,11 @@ void GameWidget::drawVictoryScreen(QPainter& painter) {
     
     // Draw shadow for glow effect
     painter.setPen(QColor(0, 0, 0, 100));
-    painter.drawText(QRect(2, 52, width(), 80), Qt::AlignCenter, "VICTORY!");
+    painter.drawText(QRect(2, 52, LOGICAL_WIDTH, 80), Qt::AlignCenter, "VICTORY!");
     
     // Draw main title
     painter.setPen(QColor(255, 255, 255));
-    painter.drawText(QRect(0, 50, width(), 80), Qt::AlignCenter, "VICTORY!");
+    painter.drawText(QRect(0, 50, LOGICAL_WIDTH, 80), Qt::AlignCenter, "VICTORY!");
     
     // Congratulations message
     painter.setPen(QColor(255, 255, 255));
@@ -777,7 +1563,7 @@ void GameWidget::drawVictoryScreen(QPainter& painter) {
     messageFont.setPointSize(28);
     messageFont.setBold(true);
     painter.setFont(messageFont);
-    painter.drawText(QRect(0, 150, width(), 40), Qt::AlignCenter, 
+    painter.drawText(QRect(0, 150, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
                     "You Escaped from the Game Master!");
     
     // Subtext
@@ -785,7 +1571,7 @@ void GameWidget::drawVictoryScreen(QPainter& painter) {
     subFont.setPointSize(20);
     painter.setFont(subFont);
     painter.setPen(QColor(240, 240, 240));
-    painter.drawText(QRect(0, 200, width(), 40), Qt::AlignCenter, 
+    painter.drawText(QRect(0, 200, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
                     "You are truly free!");
     
     // Draw decorative stars
@@ -803,10 +1589,10 @@ void GameWidget::drawVictoryScreen(QPainter& painter) {
     };
     
     drawStar(150, 100, 20);
-    drawStar(width() - 150, 100, 20);
+    drawStar(LOGICAL_WIDTH - 150, 100, 20);
     drawStar(100, 300, 15);
-    drawStar(width() - 100, 300, 15);
-    drawStar(width() / 2, 420, 18);
+    drawStar(LOGICAL_WIDTH - 100, 300, 15);
+    drawStar(LOGICAL_WIDTH / 2, 420, 18);
     
     // Final Score
     painter.setPen(QColor(255, 255, 255));
@@ -815,35 +1601,55 @@ void GameWidget::drawVictoryScreen(QPainter& painter) {
     scoreFont.setBold(true);
     painter.setFont(scoreFont);
     
-    int centerY = height() / 2 + 50;
-    painter.drawText(QRect(0, centerY, width(), 50), Qt::AlignCenter, 
-                    QString("Final Score: %1").arg(m_player->score()));
+    int centerY = LOGICAL_HEIGHT / 2 + 50;
+    painter.drawText(QRect(0, centerY, LOGICAL_WIDTH, 50), Qt::AlignCenter, 
+                    QString("Final Score: %1").arg(frame.score));
     
     // Highest score
     QFont highScoreFont;
     highScoreFont.setPointSize(24);
     painter.setFont(highScoreFont);
     painter.setPen(QColor(255, 255, 200));
-    painter.drawText(QRect(0, centerY + 60, width(), 40), Qt::AlignCenter, 
-                    QString("Highest Score: %1").arg(m_highestScore));
+    painter.drawText(QRect(0, centerY + 60, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
+                    QString("Highest Score: %1").arg(frame.highestScore));
     
     // Instructions
     QFont instFont;
     instFont.setPointSize(18);
     painter.setFont(instFont);
     painter.setPen(QColor(255, 255, 255));
-    painter.drawText(QRect(0, height() - 80, width(), 40), Qt::AlignCenter, 
+    painter.drawText(QRect(0, LOGICAL_HEIGHT - 80, LOGICAL_WIDTH, 40), Qt::AlignCenter, 
                     "Press SPACE to Play Again or ESC to Return to Menu");
 }
 
 void GameWidget::keyPressEvent(QKeyEvent* event) {
+    // Playback drives its own input
+    if (m_headless) {
+        return;
+    }
+    
+    // Applied (and recorded) between ticks on the simulation thread
+    int key = event->key();
+    bool autoRepeat = event->isAutoRepeat();
+    simulate([this, key, autoRepeat]() {
+        if (m_replayMode == ReplayMode::RECORDING) {
+            m_recording.record({ m_tick, autoRepeat ? ReplayEvent::Type::KEY_REPEAT : ReplayEvent::Type::KEY_DOWN,
+                                 key, QString() });
+        }
+        handleKeyPress(key, autoRepeat);
+    });
+    
+    QWidget::keyPressEvent(event);
+}
+
+void GameWidget::handleKeyPress(int key, bool autoRepeat) {
     // Handle victory screen input
     if (m_showVictoryScreen) {
-        if (event->key() == Qt::Key_Space) {
+        if (key == Qt::Key_Space) {
             m_showVictoryScreen = false;
             resetGame();
             return;
-        } else if (event->key() == Qt::Key_Escape) {
+        } else if (key == Qt::Key_Escape) {
             m_showVictoryScreen = false;
             // Return to main menu (emit signal or call parent)
             emit returnToMainMenu();
@@ -854,11 +1660,11 @@ void GameWidget::keyPressEvent(QKeyEvent* event) {
     
     // Handle retry screen input
     if (m_showRetryScreen) {
-        if (event->key() == Qt::Key_R) {
+        if (key == Qt::Key_R) {
             m_showRetryScreen = false;
             resetGame();
             return;
-        } else if (event->key() == Qt::Key_Escape) {
+        } else if (key == Qt::Key_Escape) {
             m_showRetryScreen = false;
             // Return to main menu (emit signal or call parent)
             emit returnToMainMenu();
@@ -867,29 +1673,117 @@ void GameWidget::keyPressEvent(QKeyEvent* event) {
         return;  // Ignore other keys on retry screen
     }
     
-    if (!event->isAutoRepeat()) {
-        m_pressedKeys.insert(event->key());
+    if (!autoRepeat) {
+        m_pressedKeys.insert(key);
     }
     
     // Pause
-    if (event->key() == Qt::Key_P || event->key() == Qt::Key_Escape) {
+    if (key == Qt::Key_P || key == Qt::Key_Escape) {
         if (m_gamePaused) {
             resumeGame();
         } else {
             pauseGame();
         }
     }
-    
-    QWidget::keyPressEvent(event);
 }
 
 void GameWidget::keyReleaseEvent(QKeyEvent* event) {
+    if (m_headless) {
+        return;
+    }
+    
     if (!event->isAutoRepeat()) {
-        m_pressedKeys.remove(event->key());
+        int key = event->key();
+        simulate([this, key]() {
+            if (m_replayMode == ReplayMode::RECORDING) {
+                m_recording.record({ m_tick, ReplayEvent::Type::KEY_UP, key, QString() });
+            }
+            m_pressedKeys.remove(key);
+        });
     }
     QWidget::keyReleaseEvent(event);
 }
 
+void GameWidget::startReplay(const QVector<ReplayEvent>& events, int levelNumber) {
+    m_headless = true;
+    m_replayMode = ReplayMode::PLAYING;
+    m_playback = events;
+    m_playbackCursor = 0;
+    // Without an END event (the recorder crashed) stop after the last input
+    m_playbackEnd = events.isEmpty() ? 0 : events.last().tick;
+    m_tick = 0;
+    startGame();
+    if (levelNumber != 1) {
+        loadLevel(levelNumber);
+    }
+    publishFrame();
+}
+
+bool GameWidget::stepReplay() {
+    if (m_replayMode != ReplayMode::PLAYING) {
+        return false;
+    }
+    
+    // Inputs recorded before this tick, in their original order
+    while (m_playbackCursor < m_playback.size() && m_playback[m_playbackCursor].tick <= m_tick) {
+        const ReplayEvent& event = m_playback[m_playbackCursor++];
+        switch (event.type) {
+            case ReplayEvent::Type::KEY_DOWN:
+            case ReplayEvent::Type::KEY_REPEAT:
+                handleKeyPress(event.key, event.type == ReplayEvent::Type::KEY_REPEAT);
+                break;
+            case ReplayEvent::Type::KEY_UP:
+                m_pressedKeys.remove(event.key);
+                break;
+            case ReplayEvent::Type::ANSWER:
+            case ReplayEvent::Type::CANCEL:
+                answerRiddle(event.type == ReplayEvent::Type::ANSWER, event.text);
+                break;
+            case ReplayEvent::Type::END:
+                break;
+        }
+    }
+    
+    step(FIXED_TIMESTEP);
+    m_tick++;
+    publishFrame();
+    return m_playbackCursor < m_playback.size() || m_tick < m_playbackEnd;
+}
+
+void GameWidget::finishBackgroundWork() {
+    m_chunkCache->finish();
+}
+
+void GameWidget::showMessage(bool warning, const QString& title, const QString& text) {
+    // Nobody to click OK during playback
+    if (m_replayMode == ReplayMode::PLAYING) {
+        return;
+    }
+    
+    // tick() waits until the box is closed
+    m_openMessages++;
+    onGuiThread([this, warning, title, text]() {
+        if (warning) {
+            QMessageBox::warning(this, title, text);
+        } else {
+            QMessageBox::information(this, title, text);
+        }
+        simulate([this]() { m_openMessages--; });
+    });
+}
+
+void GameWidget::setLabelText(QLabel* label, const QString& text) {
+    onGuiThread([label, text]() { label->setText(text); });
+}
+
+void GameWidget::simulate(std::function<void()> task) {
+    QMetaObject::invokeMethod(m_simulation, std::move(task));
+}
+
+void GameWidget::onGuiThread(std::function<void()> task) {
+    QMetaObject::invokeMethod(this, std::move(task));
+}
+
 void GameWidget::timerEvent(QTimerEvent* event) {
     QWidget::timerEvent(event);
 }
@@ -0,0 +1,179 @@
+#include "GoldenFrames.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <algorithm>
+#include <cstdlib>
+
+// Ticks each level is checked at (60 per second): the first frame, then
+// after the player has settled and enemies have moved along their patrols
+static const int CHECKED_TICKS[] = { 1, 90, 240 };
+
+GoldenFrames::GoldenFrames(Mode mode, const QString& directory, bool checkBudgets, double budgetScale)
+    : m_mode(mode)
+    , m_directory(directory)
+    , m_checkBudgets(checkBudgets)
+    , m_budgetScale(budgetScale)
+    , m_missing(0)
+{
+}
+
+int GoldenFrames::run() {
+    if (!QDir().mkpath(m_directory)) {
+        qDebug() << "Cannot create golden directory:" << m_directory;
+        return -1;
+    }
+    
+    int failures = 0;
+    for (int levelNumber = 1; levelNumber <= LEVEL_COUNT; ++levelNumber) {
+        GameWidget game;
+        game.startReplay(QVector<ReplayEvent>(), levelNumber);
+        
+        int tick = 0;
+        for (int checkedTick : CHECKED_TICKS) {
+            while (tick < checkedTick) {
+                game.stepReplay();
+                tick++;
+            }
+            
+            // Compare steady-state frames: every chunk rasterized and delivered
+            QCoreApplication::processEvents();
+            game.finishBackgroundWork();
+            
+            QString name = QString("level%1_tick%2").arg(levelNumber).arg(checkedTick);
+            if (!checkFrame(name, game.renderScene())) {
+                failures++;
+            }
+            if (!checkTimings(name, game)) {
+                failures++;
+            }
+        }
+    }
+    
+    if (m_mode == Mode::CHECK) {
+        if (failures > 0) {
+            qDebug().noquote() << QString("%1 golden checks failed").arg(failures);
+        } else if (m_missing > 0) {
+            qDebug().noquote() << QString("%1 golden frames missing, nothing to compare them with").arg(m_missing);
+        } else {
+            qDebug() << "All golden frames match";
+        }
+    }
+    return failures;
+}
+
+bool GoldenFrames::checkFrame(const QString& name, const QImage& frame) {
+    QString goldenPath = QString("%1/%2.png").arg(m_directory, name);
+    
+    if (m_mode == Mode::UPDATE) {
+        if (!frame.save(goldenPath, "PNG")) {
+            qDebug() << "Failed to write" << goldenPath;
+            return false;
+        }
+        return true;
+    }
+    
+    QImage golden(goldenPath);
+    if (golden.isNull()) {
+        qDebug() << "Missing golden frame" << goldenPath << "(run with --golden-update first)";
+        m_missing++;
+        return true;
+    }
+    
+    QImage diff;
+    int differing = countDifferingPixels(golden, frame, diff);
+    int allowed = static_cast<int>(frame.width() * frame.height() * MAX_DIFFERING_FRACTION);
+    if (differing >= 0 && differing <= allowed) {
+        return true;
+    }
+    
+    if (differing < 0) {
+        qDebug().noquote() << name << "size changed:" << golden.size() << "->" << frame.size();
+    } else {
+        qDebug().noquote() << name << "differs in" << differing << "pixels (allowed" << allowed << ")";
+    }
+    frame.save(QString("%1/%2.actual.png").arg(m_directory, name), "PNG");
+    if (!diff.isNull()) {
+        diff.save(QString("%1/%2.diff.png").arg(m_directory, name), "PNG");
+    }
+    return false;
+}
+
+bool GoldenFrames::checkTimings(const QString& name, GameWidget& game) {
+    QVector<qint64> level, sprites, overlays;
+    for (int run = 0; run < TIMING_RUNS; ++run) {
+        game.renderScene();
+        const GameWidget::PaintTimings& timings = game.lastPaintTimings();
+        level.append(timings.levelNs);
+        sprites.append(timings.spritesNs);
+        overlays.append(timings.overlaysNs);
+    }
+    
+    auto median = [](QVector<qint64>& samples) {
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    };
+    qint64 levelNs = median(level);
+    qint64 spritesNs = median(sprites);
+    qint64 overlaysNs = median(overlays);
+    
+    qDebug().noquote() << QString("%1: level %2 ms, sprites %3 ms, overlays %4 ms")
+        .arg(name, -16)
+        .arg(levelNs / 1e6, 0, 'f', 2)
+        .arg(spritesNs / 1e6, 0, 'f', 2)
+        .arg(overlaysNs / 1e6, 0, 'f', 2);
+    
+    // Updating goldens only reports the timings
+    if (m_mode == Mode::UPDATE || !m_checkBudgets) {
+        return true;
+    }
+    
+    bool withinBudget = true;
+    auto check = [&](const char* section, qint64 measured, qint64 budget) {
+        qint64 scaled = static_cast<qint64>(budget * m_budgetScale);
+        if (measured > scaled) {
+            qDebug().noquote() << QString("%1 %2 took %3 ms, budget %4 ms")
+                .arg(name).arg(section)
+                .arg(measured / 1e6, 0, 'f', 2)
+                .arg(scaled / 1e6, 0, 'f', 2);
+            withinBudget = false;
+        }
+    };
+    check("drawLevel", levelNs, LEVEL_BUDGET_NS);
+    check("sprites", spritesNs, SPRITES_BUDGET_NS);
+    check("overlays", overlaysNs, OVERLAYS_BUDGET_NS);
+    return withinBudget;
+}
+
+int GoldenFrames::countDifferingPixels(const QImage& expected, const QImage& actual, QImage& diff) {
+    if (expected.size() != actual.size()) {
+        return -1;
+    }
+    
+    QImage a = expected.convertToFormat(QImage::Format_ARGB32);
+    QImage b = actual.convertToFormat(QImage::Format_ARGB32);
+    diff = QImage(a.size(), QImage::Format_ARGB32);
+    
+    int differing = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const QRgb* rowA = reinterpret_cast<const QRgb*>(a.constScanLine(y));
+        const QRgb* rowB = reinterpret_cast<const QRgb*>(b.constScanLine(y));
+        QRgb* rowDiff = reinterpret_cast<QRgb*>(diff.scanLine(y));
+        for (int x = 0; x < a.width(); ++x) {
+            QRgb pa = rowA[x];
+            QRgb pb = rowB[x];
+            bool differs = std::abs(qRed(pa) - qRed(pb)) > CHANNEL_TOLERANCE
+                || std::abs(qGreen(pa) - qGreen(pb)) > CHANNEL_TOLERANCE
+                || std::abs(qBlue(pa) - qBlue(pb)) > CHANNEL_TOLERANCE
+                || std::abs(qAlpha(pa) - qAlpha(pb)) > CHANNEL_TOLERANCE;
+            if (differs) {
+                differing++;
+                rowDiff[x] = qRgb(255, 0, 0);
+            } else {
+                int gray = qGray(pa) / 3;
+                rowDiff[x] = qRgb(gray, gray, gray);
+            }
+        }
+    }
+    return differing;
+}
@@ -0,0 +1,256 @@
+#include "JobSystem.h"
+#include <QtGlobal>
+
+// Which system's worker the current thread is, and its queue
+static thread_local const JobSystem* t_system = nullptr;
+static thread_local int t_queue = -1;
+
+int JobSystem::Graph::add(Job job, std::initializer_list<int> dependencies) {
+    return add(std::move(job), QVector<int>(dependencies));
+}
+
+int JobSystem::Graph::add(Job job, const QVector<int>& dependencies) {
+    int id = m_nodes.size();
+    Node node;
+    node.job = std::move(job);
+    for (int dependency : dependencies) {
+        Q_ASSERT_X(dependency >= 0 && dependency < id, "JobSystem::Graph::add", "dependency is not an earlier job of this graph");
+        m_nodes[dependency].successors.append(id);
+        ++node.dependencyCount;
+    }
+    m_nodes.append(node);
+    return id;
+}
+
+JobSystem::JobSystem(int workerCount)
+    : m_quitting(0)
+{
+    if (workerCount < 0) {
+        bool ok = false;
+        workerCount = qEnvironmentVariableIntValue("DEATHRIDDLE_JOB_THREADS", &ok);
+        if (!ok || workerCount < 0) {
+            // The calling thread helps, so it counts as one
+            workerCount = std::max(0, QThread::idealThreadCount() - 1);
+        }
+    }
+    m_graphWorkers = workerCount;
+    
+    for (int index = 0; index <= workerCount; ++index) {
+        m_queues.append(new Queue);
+    }
+    for (int index = 0; index < workerCount; ++index) {
+        QThread* worker = QThread::create([this, index]() { workerLoop(index); });
+        worker->setObjectName(QString("JobSystem %1").arg(index));
+        m_workers.append(worker);
+        worker->start();
+    }
+    if (workerCount == 0) {
+        // Background jobs still must not run on whoever submits them
+        QThread* worker = QThread::create([this]() { backgroundLoop(); });
+        worker->setObjectName("JobSystem background");
+        m_workers.append(worker);
+        worker->start();
+    }
+}
+
+JobSystem::~JobSystem() {
+    m_quitting.storeRelease(1);
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_wake.wakeAll();
+    }
+    for (QThread* worker : m_workers) {
+        worker->wait();
+        delete worker;
+    }
+    
+    // Whatever never ran: only submitted jobs can be left over. Their
+    // counters are released as if they had run, so nobody waits forever.
+    for (const Task& task : m_background.tasks) {
+        if (task.graph->m_counter) {
+            task.graph->m_counter->deref();
+        }
+        delete task.graph;
+    }
+    for (Queue* queue : m_queues) {
+        delete queue;
+    }
+}
+
+void JobSystem::run(Graph& graph) {
+    if (graph.m_nodes.isEmpty()) {
+        return;
+    }
+    
+    graph.m_unfinished.storeRelaxed(graph.m_nodes.size());
+    for (Graph::Node& node : graph.m_nodes) {
+        node.waitingOn.storeRelaxed(node.dependencyCount);
+    }
+    for (int id = 0; id < graph.m_nodes.size(); ++id) {
+        if (graph.m_nodes[id].dependencyCount == 0) {
+            push({ &graph, id });
+        }
+    }
+    
+    // Help out instead of blocking, but only with graph jobs: a background
+    // job could hold this thread far longer than the graph itself
+    int self = ownQueue();
+    while (graph.m_unfinished.loadAcquire() > 0) {
+        Task task;
+        if (takeGraph(self, task)) {
+            execute(task);
+        } else {
+            // Everything left is already running on workers
+            QThread::yieldCurrentThread();
+        }
+    }
+}
+
+void JobSystem::submit(Job job, QAtomicInt* counter) {
+    Graph* graph = new Graph;
+    graph->add(std::move(job));
+    graph->m_unfinished.storeRelaxed(1);
+    graph->m_detached = true;
+    graph->m_counter = counter;
+    if (counter) {
+        counter->ref();
+    }
+    push({ graph, 0 });
+}
+
+void JobSystem::wait(const QAtomicInt& counter) {
+    while (counter.loadAcquire() > 0) {
+        Task task;
+        if (takeBackground(task)) {
+            execute(task);
+        } else {
+            QThread::yieldCurrentThread();
+        }
+    }
+}
+
+void JobSystem::workerLoop(int index) {
+    t_system = this;
+    t_queue = index;
+    while (!m_quitting.loadAcquire()) {
+        Task task;
+        if (takeGraph(index, task) || takeBackground(task)) {
+            execute(task);
+        } else {
+            sleep(true);
+        }
+    }
+}
+
+void JobSystem::backgroundLoop() {
+    while (!m_quitting.loadAcquire()) {
+        Task task;
+        if (takeBackground(task)) {
+            execute(task);
+        } else {
+            sleep(false);
+        }
+    }
+}
+
+void JobSystem::sleep(bool graphWork) {
+    // Counts are raised before the wake-up is sent under this mutex, so a
+    // task queued after the check still wakes us
+    QMutexLocker locker(&m_sleepMutex);
+    int queued = m_queuedBackground.loadAcquire();
+    if (graphWork) {
+        queued += m_queuedGraph.loadAcquire();
+    }
+    if (queued <= 0 && !m_quitting.loadAcquire()) {
+        m_wake.wait(&m_sleepMutex);
+    }
+}
+
+int JobSystem::ownQueue() const {
+    return t_system == this ? t_queue : m_queues.size() - 1;
+}
+
+void JobSystem::push(const Task& task) {
+    if (task.graph->m_detached) {
+        {
+            QMutexLocker locker(&m_background.mutex);
+            m_background.tasks.push_back(task);
+        }
+        m_queuedBackground.ref();
+    } else {
+        Queue* queue = m_queues[ownQueue()];
+        {
+            QMutexLocker locker(&queue->mutex);
+            queue->tasks.push_back(task);
+        }
+        m_queuedGraph.ref();
+        if (m_graphWorkers == 0) {
+            // The caller runs it; the background thread would only wake up
+            return;
+        }
+    }
+    
+    QMutexLocker locker(&m_sleepMutex);
+    m_wake.wakeOne();
+}
+
+bool JobSystem::takeGraph(int self, Task& task) {
+    Queue* own = m_queues[self];
+    {
+        QMutexLocker locker(&own->mutex);
+        if (!own->tasks.empty()) {
+            task = own->tasks.back();
+            own->tasks.pop_back();
+            m_queuedGraph.deref();
+            return true;
+        }
+    }
+    
+    // Steal the oldest job, starting after ourselves so victims spread out
+    for (int offset = 1; offset < m_queues.size(); ++offset) {
+        Queue* victim = m_queues[(self + offset) % m_queues.size()];
+        QMutexLocker locker(&victim->mutex);
+        if (!victim->tasks.empty()) {
+            task = victim->tasks.front();
+            victim->tasks.pop_front();
+            m_queuedGraph.deref();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::takeBackground(Task& task) {
+    // Oldest first: chunks are submitted in the order they are wanted
+    QMutexLocker locker(&m_background.mutex);
+    if (m_background.tasks.empty()) {
+        return false;
+    }
+    task = m_background.tasks.front();
+    m_background.tasks.pop_front();
+    m_queuedBackground.deref();
+    return true;
+}
+
+void JobSystem::execute(const Task& task) {
+    Graph* graph = task.graph;
+    Graph::Node& node = graph->m_nodes[task.node];
+    node.job();
+    
+    for (int successor : node.successors) {
+        if (!graph->m_nodes[successor].waitingOn.deref()) {
+            push({ graph, successor });
+        }
+    }
+    
+    // The owner may free a finished graph at once, so nothing of it is
+    // touched after the last job is counted off
+    bool detached = graph->m_detached;
+    QAtomicInt* counter = graph->m_counter;
+    if (!graph->m_unfinished.deref() && detached) {
+        delete graph;
+        if (counter) {
+            counter->deref();
+        }
+    }
+}
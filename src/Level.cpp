@@ -1,31 +1,57 @@
 #include "Level.h"
-#include "Enemy.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+// Tiles live in the level arena, which never runs destructors
+static_assert(std::is_trivially_destructible<Tile>::value, "Tile must be trivially destructible");
 
 Level::Level(int levelNumber, QObject* parent)
     : QObject(parent)
     , m_levelNumber(levelNumber)
     , m_width(30)
     , m_height(20)
+    , m_name("")
+    , m_description("")
+    , m_tiles(nullptr)
+    , m_wordsPerRow(0)
+    , m_rowBits(nullptr)
     , m_spawnPoint(64, 500)
+    , m_dark(false)
     , m_complete(false)
     , m_totalCoins(0)
     , m_coinsCollected(0)
 {
     // Initialize empty grid
-    m_tiles.resize(m_height);
+    m_tiles = m_arena.allocateArray<Tile>(m_width * m_height);
+    m_wordsPerRow = (m_width + 63) / 64;
+    m_rowBits = m_arena.allocateArray<quint64>(TILE_CLASS_COUNT * m_height * m_wordsPerRow);
     for (int y = 0; y < m_height; ++y) {
-        m_tiles[y].resize(m_width);
         for (int x = 0; x < m_width; ++x) {
-            m_tiles[y][x].gridPos = QPoint(x, y);
-            m_tiles[y][x].boundingBox = QRectF(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+            Tile& tile = m_tiles[y * m_width + x];
+            tile.gridPos = QPoint(x, y);
+            tile.boundingBox = QRectF(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
         }
     }
     
     loadLevel(levelNumber);
 }
 
-void Level::addEnemy(Enemy* enemy) {
-    m_enemies.append(enemy);
+void Level::addEnemySpawn(EnemyType type, const QPointF& position, int riddleId, const char* behaviour) {
+    m_enemySpawns.append({ type, position, riddleId, behaviour ? m_arena.copyString(behaviour) : nullptr });
+}
+
+void Level::addMovingPlatform(int x, int y, int widthTiles, const QVector<QPoint>& path, float speed) {
+    PlatformSpawn spawn;
+    spawn.box = QRectF(x * TILE_SIZE, y * TILE_SIZE, widthTiles * TILE_SIZE, TILE_SIZE / 2);
+    for (const QPoint& cell : path) {
+        spawn.waypoints.append(QPointF(cell.x() * TILE_SIZE, cell.y() * TILE_SIZE));
+    }
+    spawn.waypoints.append(spawn.box.topLeft());
+    spawn.speed = speed;
+    m_platformSpawns.append(spawn);
 }
 
 void Level::loadLevel(int levelNumber) {
@@ -44,14 +70,14 @@ Tile* Level::getTileAt(int x, int y) {
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
         return nullptr;
     }
-    return &m_tiles[y][x];
+    return &m_tiles[y * m_width + x];
 }
 
 const Tile* Level::getTileAt(int x, int y) const {
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) {
         return nullptr;
     }
-    return &m_tiles[y][x];
+    return &m_tiles[y * m_width + x];
 }
 
 Tile* Level::getTileAtPixel(float x, float y) {
@@ -84,34 +110,213 @@ QVector<Tile*> Level::getSolidTiles() {
     QVector<Tile*> result;
     for (int y = 0; y < m_height; ++y) {
         for (int x = 0; x < m_width; ++x) {
-            if (m_tiles[y][x].type == TileType::SOLID || 
-                m_tiles[y][x].type == TileType::MOVING_PLATFORM) {
-                result.append(&m_tiles[y][x]);
+            Tile& tile = m_tiles[y * m_width + x];
+            if (tile.type == TileType::SOLID || 
+                tile.type == TileType::MOVING_PLATFORM) {
+                result.append(&tile);
             }
         }
     }
     return result;
 }
 
-bool Level::isSolid(int gridX, int gridY) const {
-    const Tile* tile = getTileAt(gridX, gridY);
-    if (!tile) return false;
-    return tile->type == TileType::SOLID || tile->type == TileType::MOVING_PLATFORM;
+quint8 Level::classesOf(const Tile& tile) {
+    quint8 classes = tile.isSolid() ? SOLID_TILES : 0;
+    switch (tile.type) {
+        case TileType::SPIKE:
+            classes |= HAZARD_TILES;
+            break;
+        case TileType::COIN:
+        case TileType::KEY:
+            classes |= COLLECTIBLE_TILES;
+            break;
+        case TileType::CHECKPOINT:
+        case TileType::RIDDLE_TRIGGER:
+        case TileType::GOAL:
+            classes |= TRIGGER_TILES;
+            break;
+        default:
+            break;
+    }
+    return classes;
 }
 
-bool Level::checkCollision(const QRectF& box, TileType& hitType) {
-    QVector<Tile*> tiles = getTilesInArea(box);
-    
-    for (Tile* tile : tiles) {
-        if (tile->type != TileType::EMPTY && tile->boundingBox.intersects(box)) {
-            hitType = tile->type;
-            return true;
+void Level::updateTileClasses(const Tile& tile) {
+    int x = tile.gridPos.x();
+    quint64 bit = quint64(1) << (x & 63);
+    quint8 classes = classesOf(tile);
+    for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+        quint64& word = rowBits(c, tile.gridPos.y())[x >> 6];
+        word = (classes & (1 << c)) ? (word | bit) : (word & ~bit);
+    }
+}
+
+bool Level::cellRange(const QRectF& area, int& startX, int& endX, int& startY, int& endY) const {
+    startX = std::max(0, static_cast<int>(std::floor(area.left() / TILE_SIZE)));
+    endX = std::min(m_width - 1, static_cast<int>(std::ceil(area.right() / TILE_SIZE)) - 1);
+    startY = std::max(0, static_cast<int>(std::floor(area.top() / TILE_SIZE)));
+    endY = std::min(m_height - 1, static_cast<int>(std::ceil(area.bottom() / TILE_SIZE)) - 1);
+    return startX <= endX && startY <= endY;
+}
+
+quint64 Level::spanMask(int word, int startX, int endX) {
+    int from = std::max(startX - (word << 6), 0);
+    int to = std::min(endX - (word << 6), 63);
+    quint64 upTo = (to == 63) ? ~quint64(0) : (quint64(1) << (to + 1)) - 1;
+    return upTo & ~((quint64(1) << from) - 1);
+}
+
+bool Level::anyInArea(const QRectF& area, quint8 classes) const {
+    int startX, endX, startY, endY;
+    if (!cellRange(area, startX, endX, startY, endY)) {
+        return false;
+    }
+    
+    for (int word = startX >> 6; word <= endX >> 6; ++word) {
+        quint64 mask = spanMask(word, startX, endX);
+        for (int c = 0; c < TILE_CLASS_COUNT; ++c) {
+            if (!(classes & (1 << c))) continue;
+            for (int y = startY; y <= endY; ++y) {
+                if (rowBits(c, y)[word] & mask) return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Level::raycast(const QPointF& from, const QPointF& to, TraceHit* hit) const {
+    // Amanatides-Woo grid walk: step into whichever neighbour cell the
+    // segment reaches first, so no crossed cell is ever skipped
+    const float size = static_cast<float>(TILE_SIZE);
+    float x0 = static_cast<float>(from.x());
+    float y0 = static_cast<float>(from.y());
+    float dx = static_cast<float>(to.x()) - x0;
+    float dy = static_cast<float>(to.y()) - y0;
+    
+    int cx = static_cast<int>(std::floor(x0 / size));
+    int cy = static_cast<int>(std::floor(y0 / size));
+    int endX = static_cast<int>(std::floor(static_cast<float>(to.x()) / size));
+    int endY = static_cast<int>(std::floor(static_cast<float>(to.y()) / size));
+    
+    auto report = [&](float fraction, QPoint normal) {
+        if (hit) {
+            hit->fraction = fraction;
+            hit->position = QPointF(x0 + dx * fraction, y0 + dy * fraction);
+            hit->cell = QPoint(cx, cy);
+            hit->normal = normal;
+        }
+        return true;
+    };
+    
+    if (isSolid(cx, cy)) {
+        return report(0.0f, QPoint());
+    }
+    
+    // Distance along the segment (0..1) to the next vertical and horizontal
+    // grid line, and between successive ones
+    const float infinity = std::numeric_limits<float>::infinity();
+    int stepX = dx > 0.0f ? 1 : -1;
+    int stepY = dy > 0.0f ? 1 : -1;
+    float tMaxX = dx != 0.0f ? ((cx + (dx > 0.0f ? 1 : 0)) * size - x0) / dx : infinity;
+    float tMaxY = dy != 0.0f ? ((cy + (dy > 0.0f ? 1 : 0)) * size - y0) / dy : infinity;
+    float tDeltaX = dx != 0.0f ? size / std::abs(dx) : infinity;
+    float tDeltaY = dy != 0.0f ? size / std::abs(dy) : infinity;
+    
+    while (cx != endX || cy != endY) {
+        float crossing;
+        QPoint normal;
+        if (tMaxX < tMaxY) {
+            crossing = tMaxX;
+            cx += stepX;
+            tMaxX += tDeltaX;
+            normal = QPoint(-stepX, 0);
+        } else {
+            crossing = tMaxY;
+            cy += stepY;
+            tMaxY += tDeltaY;
+            normal = QPoint(0, -stepY);
+        }
+        if (crossing > 1.0f) {
+            break;  // Rounding walked past the end cell
+        }
+        if (isSolid(cx, cy)) {
+            return report(crossing, normal);
         }
     }
-    
     return false;
 }
 
+bool Level::sweepBox(const QRectF& box, const QPointF& delta, TraceHit* hit) const {
+    // Candidate cells: the solid ones the box covers on its way
+    int startX, endX, startY, endY;
+    if (!cellRange(box.united(box.translated(delta)), startX, endX, startY, endY)) {
+        return false;
+    }
+    
+    // Per-axis entry and exit times against one cell (slab test)
+    auto axis = [](qreal boxMin, qreal boxMax, qreal d, qreal cellMin, qreal cellMax, qreal& enter, qreal& exit) {
+        if (d > 0.0) {
+            enter = (cellMin - boxMax) / d;
+            exit = (cellMax - boxMin) / d;
+        } else if (d < 0.0) {
+            enter = (cellMax - boxMin) / d;
+            exit = (cellMin - boxMax) / d;
+        } else if (boxMax > cellMin && boxMin < cellMax) {
+            enter = -std::numeric_limits<qreal>::infinity();
+            exit = std::numeric_limits<qreal>::infinity();
+        } else {
+            return false;  // Never lines up on this axis
+        }
+        return true;
+    };
+    
+    bool found = false;
+    qreal best = 1.0;
+    for (int y = startY; y <= endY; ++y) {
+        for (int word = startX >> 6; word <= endX >> 6; ++word) {
+            quint64 bits = rowBits(0, y)[word] & spanMask(word, startX, endX);
+            for (; bits; bits &= bits - 1) {
+                int x = (word << 6) + static_cast<int>(qCountTrailingZeroBits(bits));
+                qreal enterX, exitX, enterY, exitY;
+                qreal left = x * TILE_SIZE;
+                qreal top = y * TILE_SIZE;
+                if (!axis(box.left(), box.right(), delta.x(), left, left + TILE_SIZE, enterX, exitX)
+                    || !axis(box.top(), box.bottom(), delta.y(), top, top + TILE_SIZE, enterY, exitY)) {
+                    continue;
+                }
+                
+                qreal enter = std::max(enterX, enterY);
+                qreal exit = std::min(exitX, exitY);
+                // Already overlapping (enter < 0) or missed
+                if (enter < 0.0 || enter >= exit || enter > best || (found && enter == best)) continue;
+                
+                found = true;
+                best = enter;
+                if (hit) {
+                    hit->fraction = static_cast<float>(enter);
+                    hit->position = box.topLeft() + delta * enter;
+                    hit->cell = QPoint(x, y);
+                    hit->normal = enterX > enterY ? QPoint(delta.x() > 0.0 ? -1 : 1, 0)
+                                                  : QPoint(0, delta.y() > 0.0 ? -1 : 1);
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool Level::checkCollision(const QRectF& box, TileType& hitType) {
+    // First tile of any class under the box (decoration like torches is skipped)
+    bool found = false;
+    forEachInArea(box, SOLID_TILES | HAZARD_TILES | COLLECTIBLE_TILES | TRIGGER_TILES, [&found, &hitType](Tile* tile) {
+        if (!found) {
+            hitType = tile->type;
+            found = true;
+        }
+    });
+    return found;
+}
+
 void Level::collectCoin(Tile* coin) {
     if (coin && coin->type == TileType::COIN && !coin->collected) {
         coin->collected = true;
@@ -135,17 +340,93 @@ int Level::coinsRemaining() const {
 void Level::setTile(int x, int y, TileType type, int riddleId) {
     if (x < 0 || x >= m_width || y < 0 || y >= m_height) return;
     
-    m_tiles[y][x].type = type;
-    m_tiles[y][x].riddleId = riddleId;
+    Tile& tile = m_tiles[y * m_width + x];
+    tile.type = type;
+    tile.riddleId = riddleId;
+    updateTileClasses(tile);
     
     if (type == TileType::COIN) {
         m_totalCoins++;
     }
 }
 
+void Level::setBreakable(int x, int y, bool respawns) {
+    setTile(x, y, TileType::BREAKABLE);
+    if (Tile* tile = getTileAt(x, y)) {
+        tile->respawns = respawns;
+    }
+}
+
+void Level::crumbleTile(Tile* tile) {
+    if (!tile || tile->type != TileType::BREAKABLE || tile->activated || tile->collected) return;
+    
+    tile->activated = true;
+    m_breakTimers.append({ tile, CRUMBLE_TIME });
+    emit tileChanged(tile->gridPos.x(), tile->gridPos.y());
+}
+
+void Level::breakTile(Tile* tile) {
+    if (!tile || tile->type != TileType::BREAKABLE || tile->collected) return;
+    
+    bool wasCrumbling = tile->activated;
+    tile->activated = true;
+    tile->collected = true;
+    updateTileClasses(*tile);
+    
+    // A crumbling block already has a timer; it becomes the respawn timer
+    if (wasCrumbling) {
+        for (BreakTimer& timer : m_breakTimers) {
+            if (timer.tile == tile) timer.remaining = RESPAWN_TIME;
+        }
+        if (!tile->respawns) {
+            m_breakTimers.erase(std::remove_if(m_breakTimers.begin(), m_breakTimers.end(),
+                [tile](const BreakTimer& timer) { return timer.tile == tile; }), m_breakTimers.end());
+        }
+    } else if (tile->respawns) {
+        m_breakTimers.append({ tile, RESPAWN_TIME });
+    }
+    emit tileChanged(tile->gridPos.x(), tile->gridPos.y());
+}
+
+void Level::updateBreakables(float deltaTime, const QRectF& keepClear) {
+    for (int i = 0; i < m_breakTimers.size(); ) {
+        BreakTimer& timer = m_breakTimers[i];
+        timer.remaining -= deltaTime;
+        if (timer.remaining > 0.0f) {
+            ++i;
+            continue;
+        }
+        
+        Tile* tile = timer.tile;
+        if (!tile->collected) {
+            // Crumble time is up
+            tile->collected = true;
+            updateTileClasses(*tile);
+            if (tile->respawns) {
+                timer.remaining = RESPAWN_TIME;
+                ++i;
+            } else {
+                m_breakTimers[i] = m_breakTimers.last();
+                m_breakTimers.removeLast();
+            }
+        } else if (!tile->boundingBox.intersects(keepClear)) {
+            // Grow back, unless that would trap someone
+            tile->collected = false;
+            tile->activated = false;
+            updateTileClasses(*tile);
+            m_breakTimers[i] = m_breakTimers.last();
+            m_breakTimers.removeLast();
+        } else {
+            ++i;
+            continue;
+        }
+        emit tileChanged(tile->gridPos.x(), tile->gridPos.y());
+    }
+}
+
 void Level::createLevel1() {
-    m_name = "Level 1: The Awakening";
-    m_description = "Learn the basics. Move with arrow keys, collect coins, reach the goal!";
+    m_name = m_arena.copyString("Level 1: The Awakening");
+    m_description = m_arena.copyString("Learn the basics. Move with arrow keys, collect coins, reach the goal!");
     m_spawnPoint = QPointF(64, 500);
     
     // Ground
@@ -181,8 +462,7 @@ void Level::createLevel1() {
         setTile(x, 12, TileType::SOLID);
     }
     // Add enemy (pink monster) with riddle 0
-    Enemy* enemy1 = new Enemy(Enemy::Type::PINK_MONSTER, QPointF(21 * TILE_SIZE, 11 * TILE_SIZE), 0, this);
-    addEnemy(enemy1);
+    addEnemySpawn(EnemyType::PINK_MONSTER, QPointF(21 * TILE_SIZE, 11 * TILE_SIZE), 0);
     setTile(23, 11, TileType::COIN);
     
     // Path to goal
@@ -195,8 +475,8 @@ void Level::createLevel1() {
 }
 
 void Level::createLevel2() {
-    m_name = "Level 2: The Cipher Challenge";
-    m_description = "Navigate platforms and solve the ROT13 riddle!";
+    m_name = m_arena.copyString("Level 2: The Cipher Challenge");
+    m_description = m_arena.copyString("Navigate platforms and solve the ROT13 riddle!");
     m_spawnPoint = QPointF(64, 500);
     
     // Ground
@@ -230,8 +510,7 @@ void Level::createLevel2() {
     }
     setTile(17, 14, TileType::COIN);
     // Add enemy (owlet monster) with riddle 1 - Cipher riddle
-    Enemy* enemy2 = new Enemy(Enemy::Type::OWLET_MONSTER, QPointF(18 * TILE_SIZE, 14 * TILE_SIZE), 1, this);
-    addEnemy(enemy2);
+    addEnemySpawn(EnemyType::OWLET_MONSTER, QPointF(18 * TILE_SIZE, 14 * TILE_SIZE), 1);
     
     // Path to goal
     for (int x = 20; x < m_width; ++x) {
@@ -241,8 +520,8 @@ void Level::createLevel2() {
 }
 
 void Level::createLevel3() {
-    m_name = "Level 3: Logic Leap";
-    m_description = "Test your jumping skills and logical thinking!";
+    m_name = m_arena.copyString("Level 3: Logic Leap");
+    m_description = m_arena.copyString("Test your jumping skills and logical thinking!");
     m_spawnPoint = QPointF(64, 500);
     
     // Ground with gaps
@@ -262,9 +541,14 @@ void Level::createLevel3() {
     for (int x = 20; x < 23; ++x) {
         setTile(x, 12, TileType::SOLID);
     }
+    
+    // Lift from the ground gap up to the first platform, and a shuttle
+    // over the gap before the goal
+    addMovingPlatform(8, 18, 2, { QPoint(8, 15) }, 40.0f);
+    addMovingPlatform(23, 12, 2, { QPoint(24, 11) }, 30.0f);
+    
     // Add enemy (pink monster) with riddle 2 - Logic riddle
-    Enemy* enemy3 = new Enemy(Enemy::Type::PINK_MONSTER, QPointF(21 * TILE_SIZE, 11 * TILE_SIZE), 2, this);
-    addEnemy(enemy3);
+    addEnemySpawn(EnemyType::PINK_MONSTER, QPointF(21 * TILE_SIZE, 11 * TILE_SIZE), 2);
     
     // Checkpoint
     setTile(21, 10, TileType::CHECKPOINT);
@@ -277,8 +561,8 @@ void Level::createLevel3() {
 }
 
 void Level::createLevel4() {
-    m_name = "Level 4: Binary Bridge";
-    m_description = "Cross the binary bridge and decode the message!";
+    m_name = m_arena.copyString("Level 4: Binary Bridge");
+    m_description = m_arena.copyString("Cross the binary bridge and decode the message!");
     m_spawnPoint = QPointF(64, 500);
     
     // Starting platform
@@ -293,11 +577,11 @@ void Level::createLevel4() {
         setTile(x, 19, TileType::SPIKE);
     }
     
-    // Floating platforms (binary pattern)
-    setTile(7, 16, TileType::SOLID);   // 0
+    // Floating platforms (binary pattern); the zeros crumble underfoot and grow back
+    setBreakable(7, 16, true);         // 0
     setTile(9, 16, TileType::SOLID);   // 1
-    setTile(11, 16, TileType::SOLID);  // 0
-    setTile(13, 16, TileType::SOLID);  // 0
+    setBreakable(11, 16, true);        // 0
+    setBreakable(13, 16, true);        // 0
     
     setTile(15, 14, TileType::SOLID);  // 0
     setTile(17, 14, TileType::SOLID);  // 1
@@ -309,8 +593,7 @@ void Level::createLevel4() {
         setTile(x, 13, TileType::SOLID);
     }
     // Enemy with binary riddle
-    Enemy* enemy4 = new Enemy(Enemy::Type::OWLET_MONSTER, QPointF(25 * TILE_SIZE, 12 * TILE_SIZE), 3, this);
-    addEnemy(enemy4);
+    addEnemySpawn(EnemyType::OWLET_MONSTER, QPointF(25 * TILE_SIZE, 12 * TILE_SIZE), 3);
     
     // Goal
     setTile(28, 15, TileType::SOLID);
@@ -318,9 +601,10 @@ void Level::createLevel4() {
 }
 
 void Level::createLevel5() {
-    m_name = "Level 5: The Final Test";
-    m_description = "Solve the ultimate riddle and escape from the Game Master!";
+    m_name = m_arena.copyString("Level 5: The Final Test");
+    m_description = m_arena.copyString("Solve the ultimate riddle and escape from the Game Master!");
     m_spawnPoint = QPointF(64, 500);
+    m_dark = true;
     
     // Complex level with all elements
     for (int x = 0; x < m_width; ++x) {
@@ -354,20 +638,40 @@ void Level::createLevel5() {
             setTile(x, y, TileType::SOLID);
         }
     }
-    // Final enemy with riddle
-    Enemy* enemy5 = new Enemy(Enemy::Type::PINK_MONSTER, QPointF(19 * TILE_SIZE, 12 * TILE_SIZE), 4, this);
-    addEnemy(enemy5);
+    // Final enemy with riddle: guards its block, pausing now and then, and
+    // runs at the player once it sees them close by
+    addEnemySpawn(EnemyType::PINK_MONSTER, QPointF(19 * TILE_SIZE, 12 * TILE_SIZE), 4,
+        "start:\n"
+        "    dist r0\n"
+        "    jump_greater r0 192 guard\n"
+        "    sees r1\n"
+        "    jump_less r1 1 guard\n"
+        "    face_player\n"
+        "    chase 50\n"
+        "    jump start\n"
+        "guard:\n"
+        "    patrol\n"
+        "    add r2 1\n"
+        "    jump_less r2 240 start\n"
+        "    set r2 0\n"
+        "    wait 1\n");
     
     // Goal
     for (int x = 24; x < m_width; ++x) {
         setTile(x, 15, TileType::SOLID);
     }
     setTile(28, 14, TileType::GOAL);
+    
+    // Torches along the way through the dark
+    setTile(3, 16, TileType::TORCH);
+    setTile(11, 15, TileType::TORCH);
+    setTile(15, 18, TileType::TORCH);
+    setTile(23, 18, TileType::TORCH);
 }
 
 void Level::createLevel6() {
-    m_name = "Level 6: The Labyrinth";
-    m_description = "Navigate the maze and find the key to escape!";
+    m_name = m_arena.copyString("Level 6: The Labyrinth");
+    m_description = m_arena.copyString("Navigate the maze and find the key to escape!");
     
     // Simple, clean maze design with open passages
     int offsetX = 1;
@@ -0,0 +1,63 @@
+#include "LevelArena.h"
+#include <cstdint>
+#include <cstring>
+
+LevelArena::LevelArena(size_t blockSize)
+    : m_head(nullptr)
+    , m_cursor(nullptr)
+    , m_end(nullptr)
+    , m_blockSize(blockSize)
+    , m_used(0)
+{
+}
+
+LevelArena::~LevelArena() {
+    release();
+}
+
+void LevelArena::addBlock(size_t minSize) {
+    // Oversized requests get a block of their own
+    size_t size = sizeof(Block) + alignof(std::max_align_t) + minSize;
+    if (size < m_blockSize) {
+        size = m_blockSize;
+    }
+    
+    Block* block = static_cast<Block*>(::operator new(size));
+    block->next = m_head;
+    m_head = block;
+    m_cursor = reinterpret_cast<char*>(block) + sizeof(Block);
+    m_end = reinterpret_cast<char*>(block) + size;
+}
+
+void* LevelArena::allocate(size_t size, size_t alignment) {
+    uintptr_t current = reinterpret_cast<uintptr_t>(m_cursor);
+    uintptr_t aligned = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    
+    if (!m_cursor || aligned + size > reinterpret_cast<uintptr_t>(m_end)) {
+        addBlock(size + alignment);
+        current = reinterpret_cast<uintptr_t>(m_cursor);
+        aligned = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    
+    m_cursor = reinterpret_cast<char*>(aligned + size);
+    m_used += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+const char* LevelArena::copyString(const char* str) {
+    size_t length = std::strlen(str) + 1;
+    char* copy = static_cast<char*>(allocate(length, 1));
+    std::memcpy(copy, str, length);
+    return copy;
+}
+
+void LevelArena::release() {
+    while (m_head) {
+        Block* next = m_head->next;
+        ::operator delete(m_head);
+        m_head = next;
+    }
+    m_cursor = nullptr;
+    m_end = nullptr;
+    m_used = 0;
+}
@@ -0,0 +1,130 @@
+#include "LevelChunkCache.h"
+#include "JobSystem.h"
+#include <QPainter>
+#include <QMetaObject>
+#include <QCoreApplication>
+#include <algorithm>
+
+LevelChunkCache::LevelChunkCache(TilePainter tilePainter, JobSystem& jobs, QObject* parent)
+    : QObject(parent)
+    , m_tilePainter(tilePainter)
+    , m_jobs(jobs)
+    , m_pending(0)
+    , m_serial(0)
+    , m_rows(0)
+    , m_generation(0)
+{
+}
+
+LevelChunkCache::~LevelChunkCache() {
+    // Workers post back to this object, so none may outlive it; queued
+    // ones skip painting once the generation moves on
+    m_generation.ref();
+    m_jobs.wait(m_pending);
+}
+
+LevelChunkCache::Snapshot LevelChunkCache::capture(const Level* level, int serial) {
+    Snapshot snapshot;
+    snapshot.serial = serial;
+    if (!level) {
+        return snapshot;
+    }
+    
+    snapshot.rows = level->height();
+    int chunkCount = (level->width() + CHUNK_COLUMNS - 1) / CHUNK_COLUMNS;
+    for (int index = 0; index < chunkCount; ++index) {
+        snapshot.chunks.append(captureChunk(level, index));
+    }
+    return snapshot;
+}
+
+QVector<Tile> LevelChunkCache::captureChunk(const Level* level, int index) {
+    QVector<Tile> tiles;
+    int firstColumn = index * CHUNK_COLUMNS;
+    int lastColumn = std::min(level->width(), firstColumn + CHUNK_COLUMNS);
+    for (int y = 0; y < level->height(); ++y) {
+        for (int x = firstColumn; x < lastColumn; ++x) {
+            const Tile* tile = level->getTileAt(x, y);
+            if (tile && isStatic(*tile)) {
+                tiles.append(*tile);
+            }
+        }
+    }
+    return tiles;
+}
+
+void LevelChunkCache::rebuild(const Snapshot& level) {
+    // Jobs that have not started yet see the new generation and skip painting
+    m_generation.ref();
+    
+    m_serial = level.serial;
+    m_rows = level.rows;
+    int chunkCount = level.chunks.size();
+    m_chunks.clear();
+    m_chunks.resize(chunkCount);
+    m_versions.fill(0, chunkCount);
+    for (int index = 0; index < chunkCount; ++index) {
+        queueChunk(index, level.chunks[index]);
+    }
+}
+
+void LevelChunkCache::invalidate(int serial, int index, const QVector<Tile>& tiles) {
+    if (serial != m_serial || index < 0 || index >= m_chunks.size()) {
+        return;
+    }
+    
+    // Drawn tile by tile until the new image is delivered
+    m_chunks[index] = QImage();
+    ++m_versions[index];
+    queueChunk(index, tiles);
+}
+
+void LevelChunkCache::queueChunk(int index, const QVector<Tile>& tiles) {
+    int generation = m_generation.loadRelaxed();
+    int version = m_versions[index];
+    QSize chunkSize(CHUNK_COLUMNS * Level::TILE_SIZE, m_rows * Level::TILE_SIZE);
+    QPoint origin = chunkOrigin(index);
+    TilePainter tilePainter = m_tilePainter;
+    m_jobs.submit([this, generation, index, version, tiles, origin, chunkSize, tilePainter]() {
+        if (generation != m_generation.loadRelaxed()) {
+            return;
+        }
+        
+        QImage image(chunkSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        
+        QPainter painter(&image);
+        painter.translate(-origin);
+        for (const Tile& tile : tiles) {
+            tilePainter(painter, &tile);
+        }
+        painter.end();
+        
+        QMetaObject::invokeMethod(this, [this, generation, index, version, image]() {
+            onChunkRendered(generation, index, version, image);
+        }, Qt::QueuedConnection);
+    }, &m_pending);
+}
+
+void LevelChunkCache::finish() {
+    m_jobs.wait(m_pending);
+    // Deliver the queued hand-backs now instead of on the next event loop pass
+    QCoreApplication::sendPostedEvents(this);
+}
+
+const QImage* LevelChunkCache::chunk(int index) const {
+    if (index < 0 || index >= m_chunks.size() || m_chunks[index].isNull()) {
+        return nullptr;
+    }
+    return &m_chunks[index];
+}
+
+void LevelChunkCache::onChunkRendered(int generation, int index, int version, const QImage& image) {
+    if (generation != m_generation.loadRelaxed() || version != m_versions[index]) {
+        // Painted for a level or tile state that has since been replaced
+        return;
+    }
+    
+    m_chunks[index] = image;
+    emit chunkReady(index);
+}
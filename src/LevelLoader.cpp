@@ -0,0 +1,70 @@
+#include "LevelLoader.h"
+#include "Level.h"
+#include <QMetaObject>
+
+LevelLoader::LevelLoader(QObject* parent)
+    : QObject(parent)
+    , m_worker(new QObject())
+    , m_requestedLevel(-1)
+    , m_request(0)
+{
+    m_workerThread.setObjectName("LevelLoader");
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_workerThread.start(QThread::LowPriority);
+}
+
+LevelLoader::~LevelLoader() {
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void LevelLoader::prefetch(int levelNumber) {
+    if (m_requestedLevel == levelNumber) {
+        return;
+    }
+    
+    m_ready.reset();
+    m_requestedLevel = levelNumber;
+    int request = ++m_request;
+    QThread* target = thread();
+    
+    QMetaObject::invokeMethod(m_worker, [this, levelNumber, request, target]() {
+        // Built without a parent on the worker, then pushed to the loader's
+        // thread before anyone else can see it. The queued call owns the
+        // level until it runs, so a loader destroyed in the meantime drops
+        // the call and the level with it.
+        std::unique_ptr<Level> level(new Level(levelNumber));
+        level->moveToThread(target);
+        QMetaObject::invokeMethod(this, [this, level = std::move(level), request]() mutable {
+            onLevelBuilt(std::move(level), request);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void LevelLoader::onLevelBuilt(std::unique_ptr<Level> level, int request) {
+    if (request != m_request) {
+        // A newer prefetch (or a take) superseded this one
+        return;
+    }
+    
+    m_ready = std::move(level);
+}
+
+Level* LevelLoader::take(int levelNumber) {
+    if (!isReady(levelNumber)) {
+        // Drop whatever is in flight; the caller will build synchronously
+        if (m_requestedLevel == levelNumber) {
+            ++m_request;
+            m_requestedLevel = -1;
+        }
+        return nullptr;
+    }
+    
+    m_requestedLevel = -1;
+    return m_ready.release();
+}
+
+bool LevelLoader::isReady(int levelNumber) const {
+    return m_ready && m_ready->levelNumber() == levelNumber;
+}
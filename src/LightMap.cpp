@@ -0,0 +1,186 @@
+#include "LightMap.h"
+#include "Level.h"
+#include <algorithm>
+
+// Calls f(neighbourIndex) for the in-bounds 4-neighbours of index
+template<typename F>
+static inline void forEachNeighbour(int index, int width, int height, F f) {
+    int x = index % width;
+    int y = index / width;
+    if (x > 0) f(index - 1);
+    if (x < width - 1) f(index + 1);
+    if (y > 0) f(index - width);
+    if (y < height - 1) f(index + width);
+}
+
+LightMap::LightMap()
+    : m_level(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_playerCell(-1, -1)
+{
+}
+
+void LightMap::reset(const Level* level) {
+    m_level = (level && level->isDark()) ? level : nullptr;
+    m_playerCell = QPoint(-1, -1);
+    if (!m_level) {
+        m_width = m_height = 0;
+        m_light.clear();
+        m_emission.clear();
+        m_shade.clear();
+        m_shadeMask = QImage();
+        return;
+    }
+    
+    m_width = level->width();
+    m_height = level->height();
+    m_light.fill(0, m_width * m_height);
+    m_emission.fill(0, m_width * m_height);
+    m_shade.fill(0, m_width * m_height);
+    m_shadeMask = QImage(m_width, m_height, QImage::Format_ARGB32_Premultiplied);
+    m_shadeMask.fill(shadeFor(0));
+    
+    // Seed every source, then one flood fill for the whole level
+    m_spreadQueue.clear();
+    for (int index = 0; index < m_width * m_height; ++index) {
+        m_emission[index] = static_cast<quint8>(emissionOf(*level->getTileAt(index % m_width, index / m_width)));
+        if (m_emission[index] > 0 && !isOpaque(index)) {
+            setLight(index, m_emission[index]);
+            m_spreadQueue.append(index);
+        }
+    }
+    propagate();
+}
+
+void LightMap::tileChanged(int x, int y) {
+    if (!isEnabled() || x < 0 || x >= m_width || y < 0 || y >= m_height) {
+        return;
+    }
+    int index = y * m_width + x;
+    m_emission[index] = static_cast<quint8>(emissionOf(*m_level->getTileAt(x, y)));
+    relight(index);
+}
+
+void LightMap::setPlayerCell(const QPoint& cell) {
+    if (!isEnabled() || cell == m_playerCell) {
+        return;
+    }
+    
+    QPoint previous = m_playerCell;
+    m_playerCell = cell;
+    if (previous.x() >= 0 && previous.x() < m_width && previous.y() >= 0 && previous.y() < m_height) {
+        relight(previous.y() * m_width + previous.x());
+    }
+    if (cell.x() >= 0 && cell.x() < m_width && cell.y() >= 0 && cell.y() < m_height) {
+        relight(cell.y() * m_width + cell.x());
+    }
+}
+
+int LightMap::lightAt(int x, int y) const {
+    if (!isEnabled() || x < 0 || x >= m_width || y < 0 || y >= m_height) {
+        return MAX_LIGHT;
+    }
+    return m_light[y * m_width + x];
+}
+
+QRgb LightMap::shadeFor(int light) {
+    // Never fully black, so the level outline stays readable
+    int alpha = 235 * (MAX_LIGHT - light) / MAX_LIGHT;
+    return static_cast<QRgb>(alpha) << 24;
+}
+
+int LightMap::emissionOf(const Tile& tile) {
+    switch (tile.type) {
+        case TileType::TORCH: return 12;
+        case TileType::GOAL: return 10;
+        case TileType::KEY: return tile.collected ? 0 : 6;
+        case TileType::COIN: return tile.collected ? 0 : 4;
+        case TileType::CHECKPOINT: return tile.activated ? 8 : 0;
+        default: return 0;
+    }
+}
+
+bool LightMap::isOpaque(int index) const {
+    return m_level->getTileAt(index % m_width, index / m_width)->type == TileType::SOLID;
+}
+
+int LightMap::emissionAt(int index) const {
+    int emission = m_emission[index];
+    if (index == m_playerCell.y() * m_width + m_playerCell.x()) {
+        emission = std::max(emission, PLAYER_LIGHT);
+    }
+    return isOpaque(index) ? 0 : emission;
+}
+
+void LightMap::relight(int index) {
+    // Clear the light that may have come through this cell: neighbours
+    // dimmer than the cleared value were lit by it and are cleared in turn,
+    // brighter ones are lit from elsewhere and flow back in afterwards
+    m_removeQueue.clear();
+    m_spreadQueue.clear();
+    m_removeQueue.append({ index, m_light[index] });
+    setLight(index, 0);
+    
+    for (int head = 0; head < m_removeQueue.size(); ++head) {
+        Removal removal = m_removeQueue[head];
+        
+        // Sources caught in the cleared region light up again
+        int emission = emissionAt(removal.index);
+        if (emission > m_light[removal.index]) {
+            setLight(removal.index, emission);
+            m_spreadQueue.append(removal.index);
+        }
+        
+        forEachNeighbour(removal.index, m_width, m_height, [this, &removal](int neighbour) {
+            int light = m_light[neighbour];
+            if (light != 0 && light < removal.light) {
+                m_removeQueue.append({ neighbour, light });
+                setLight(neighbour, 0);
+            } else if (light > 0 && light >= removal.light) {
+                m_spreadQueue.append(neighbour);
+            }
+        });
+    }
+    
+    propagate();
+}
+
+void LightMap::propagate() {
+    for (int head = 0; head < m_spreadQueue.size(); ++head) {
+        int index = m_spreadQueue[head];
+        int next = m_light[index] - 1;
+        if (next <= 0) continue;
+        
+        forEachNeighbour(index, m_width, m_height, [this, next](int neighbour) {
+            if (m_light[neighbour] < next && !isOpaque(neighbour)) {
+                setLight(neighbour, next);
+                m_spreadQueue.append(neighbour);
+            }
+        });
+    }
+    m_spreadQueue.clear();
+}
+
+void LightMap::setLight(int index, int light) {
+    m_light[index] = static_cast<quint8>(light);
+    updateShade(index);
+    
+    // Walls show the light that reaches their face
+    forEachNeighbour(index, m_width, m_height, [this](int neighbour) {
+        if (isOpaque(neighbour)) {
+            updateShade(neighbour);
+        }
+    });
+}
+
+void LightMap::updateShade(int index) {
+    int light = m_light[index];
+    if (isOpaque(index)) {
+        forEachNeighbour(index, m_width, m_height, [this, &light](int neighbour) {
+            light = std::max(light, m_light[neighbour] - 1);
+        });
+    }
+    m_shade[index] = static_cast<quint8>(light);
+    reinterpret_cast<QRgb*>(m_shadeMask.scanLine(index / m_width))[index % m_width] = shadeFor(light);
+}
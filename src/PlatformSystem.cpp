@@ -0,0 +1,88 @@
+#include "PlatformSystem.h"
+#include <QLineF>
+#include <cmath>
+
+Entity PlatformSystem::spawn(EntityStore& store, const QRectF& box, const QVector<QPointF>& waypoints, float speed) {
+    Entity platform = store.create(EntityStore::TRANSFORM | EntityStore::BODY | EntityStore::PLATFORM | EntityStore::COLLIDER);
+    store.position(platform) = box.topLeft();
+    store.size(platform) = box.size();
+    
+    PlatformComponent& data = store.platform(platform);
+    data.waypoints = waypoints;
+    data.target = 0;
+    data.speed = speed;
+    data.delta = QPointF();
+    return platform;
+}
+
+void PlatformSystem::update(EntityStore& store, float deltaTime) {
+    store.forEach(EntityStore::PLATFORM, [&store, deltaTime](Entity platform) {
+        PlatformComponent& data = store.platform(platform);
+        QPointF& position = store.position(platform);
+        QPointF start = position;
+        
+        // Spend this update's travel, turning at waypoints along the way
+        float travel = data.speed * deltaTime;
+        int turns = 0;
+        while (travel > 0.0f && !data.waypoints.isEmpty() && turns <= data.waypoints.size()) {
+            QPointF target = data.waypoints[data.target];
+            float distance = static_cast<float>(QLineF(position, target).length());
+            if (distance > travel) {
+                position += (target - position) * (travel / distance);
+                break;
+            }
+            position = target;
+            travel -= distance;
+            data.target = (data.target + 1) % data.waypoints.size();
+            turns++;
+        }
+        
+        data.delta = position - start;
+        store.velocity(platform) = deltaTime > 0.0f ? data.delta / deltaTime : QPointF();
+    });
+    
+    // Enemies standing on a platform move with it, patrol route included
+    store.forEach(EntityStore::PLATFORM, [&store](Entity platform) {
+        const PlatformComponent& data = store.platform(platform);
+        if (data.delta.isNull()) return;
+        
+        // The tree still holds last update's boxes; the margin covers the difference
+        QRectF top = store.boundingBox(platform).translated(-data.delta);
+        QRectF riders(top.left(), top.top() - STANDING_TOLERANCE, top.width(), 2 * STANDING_TOLERANCE);
+        store.queryColliders(riders.adjusted(0, -DynamicAabbTree::MARGIN, 0, DynamicAabbTree::MARGIN),
+                             [&store, &data, &top](Entity enemy) {
+            if (!store.has(enemy, EntityStore::ENEMY)) return;
+            
+            QRectF box = store.boundingBox(enemy);
+            if (std::abs(box.bottom() - top.top()) <= STANDING_TOLERANCE
+                && box.right() > top.left() && box.left() < top.right()) {
+                store.position(enemy) += data.delta;
+                store.enemy(enemy).patrolOrigin += data.delta;
+            }
+        });
+    });
+}
+
+QPointF PlatformSystem::carryDelta(const EntityStore& store, const QRectF& box) {
+    // Feet against the platform tops as they were before this update
+    QPointF carried;
+    QRectF feet(box.left(), box.bottom() - STANDING_TOLERANCE, box.width(), 2 * STANDING_TOLERANCE);
+    store.queryColliders(feet.adjusted(0, -DynamicAabbTree::MARGIN, 0, DynamicAabbTree::MARGIN),
+                         [&store, &box, &carried](Entity entity) {
+        if (!store.has(entity, EntityStore::PLATFORM)) return;
+        
+        const PlatformComponent& data = store.platform(entity);
+        QRectF top = store.boundingBox(entity).translated(-data.delta);
+        if (std::abs(box.bottom() - top.top()) <= STANDING_TOLERANCE
+            && box.right() > top.left() && box.left() < top.right()) {
+            carried = data.delta;
+        }
+    });
+    return carried;
+}
+
+void PlatformSystem::clear(EntityStore& store) {
+    store.forEach(EntityStore::PLATFORM, [&store](Entity platform) {
+        store.destroy(platform);
+    });
+}
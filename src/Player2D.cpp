@@ -1,164 +1,134 @@
 #include "Player2D.h"
 #include <algorithm>
-#include <QDebug>
 
-Player2D::Player2D(QObject* parent)
+Player2D::Player2D(EntityStore& store, QObject* parent)
     : QObject(parent)
-    , m_position(100, 100)
-    , m_velocity(0, 0)
+    , m_store(store)
+    , m_entity(store.create(EntityStore::TRANSFORM | EntityStore::BODY | EntityStore::SPRITE))
     , m_spawnPoint(100, 100)
     , m_state(State::IDLE)
     , m_onGround(false)
     , m_canJump(true)
-    , m_facingRight(true)
     , m_hasDoubleJump(true)
     , m_doubleJumpCooldown(0.0f)
+    , m_throwCooldown(0.0f)
     , m_health(100)
     , m_lives(3)
     , m_score(0)
     , m_coins(0)
 {
-    loadAnimations();
+    m_store.position(m_entity) = QPointF(100, 100);
+    m_store.size(m_entity) = QSizeF(WIDTH, HEIGHT);
+    m_store.setFacingRight(m_entity, true);
+    m_store.animation(m_entity).start(clipFor(m_state));
 }
 
-void Player2D::loadAnimations() {
-    // Load sprite sheets for different animations
-    QString basePath = "assets/sprites/";
+const AnimationClip& Player2D::clipFor(State state) {
+    // Built once and shared; each state gets its own entry, so RUNNING_LEFT and
+    // RUNNING_RIGHT no longer share a playhead
+    static const QVector<AnimationClip> clips = []() {
+        QString basePath = "assets/sprites/";
+        const SpriteSheet* idle = SpriteSheet::get(basePath + "Dude_Monster_Idle_4.png", 32, 32, 4);
+        const SpriteSheet* run = SpriteSheet::get(basePath + "Dude_Monster_Run_6.png", 32, 32, 6);
+        const SpriteSheet* jump = SpriteSheet::get(basePath + "Dude_Monster_Jump_8.png", 32, 32, 8);
+        const SpriteSheet* hurt = SpriteSheet::get(basePath + "Dude_Monster_Hurt_4.png", 32, 32, 4);
+        const SpriteSheet* death = SpriteSheet::get(basePath + "Dude_Monster_Death_8.png", 32, 32, 8);
+        const SpriteSheet* toss = SpriteSheet::get(basePath + "Dude_Monster_Throw_4.png", 32, 32, 4);
+        
+        QVector<AnimationClip> table(8);
+        table[static_cast<int>(State::IDLE)] = { idle, 10.0f, true };
+        table[static_cast<int>(State::RUNNING_LEFT)] = { run, 18.0f, true };
+        table[static_cast<int>(State::RUNNING_RIGHT)] = { run, 18.0f, true };
+        table[static_cast<int>(State::JUMPING)] = { jump, 20.0f, false };
+        table[static_cast<int>(State::FALLING)] = { jump, 20.0f, false };
+        table[static_cast<int>(State::HURT)] = { hurt, 15.0f, false };
+        table[static_cast<int>(State::DEAD)] = { death, 12.0f, false };
+        table[static_cast<int>(State::THROWING)] = { toss, 16.0f, false };
+        return table;
+    }();
     
-    // Idle animation (4 frames)
-    AnimatedSprite* idleSprite = new AnimatedSprite();
-    if (idleSprite->loadSpriteSheet(basePath + "Dude_Monster_Idle_4.png", 32, 32, 4)) {
-        idleSprite->setFrameRate(10.0f);  // Increased from 8 to 10 FPS
-        idleSprite->setLoop(true);
-        idleSprite->play();
-        m_animations[State::IDLE] = idleSprite;
-    } else {
-        qDebug() << "Failed to load idle animation";
-        delete idleSprite;
-    }
-    
-    // Run animation (6 frames) - used for both left and right
-    AnimatedSprite* runSprite = new AnimatedSprite();
-    if (runSprite->loadSpriteSheet(basePath + "Dude_Monster_Run_6.png", 32, 32, 6)) {
-        runSprite->setFrameRate(18.0f);  // Increased from 12 to 18 FPS
-        runSprite->setLoop(true);
-        runSprite->play();
-        m_animations[State::RUNNING_LEFT] = runSprite;
-        m_animations[State::RUNNING_RIGHT] = runSprite;
-    } else {
-        qDebug() << "Failed to load run animation";
-        delete runSprite;
-    }
-    
-    // Jump animation (8 frames)
-    AnimatedSprite* jumpSprite = new AnimatedSprite();
-    if (jumpSprite->loadSpriteSheet(basePath + "Dude_Monster_Jump_8.png", 32, 32, 8)) {
-        jumpSprite->setFrameRate(20.0f);  // Increased from 15 to 20 FPS
-        jumpSprite->setLoop(false);
-        jumpSprite->play();
-        m_animations[State::JUMPING] = jumpSprite;
-        m_animations[State::FALLING] = jumpSprite;
-    } else {
-        qDebug() << "Failed to load jump animation";
-        delete jumpSprite;
-    }
-    
-    // Hurt animation (4 frames)
-    AnimatedSprite* hurtSprite = new AnimatedSprite();
-    if (hurtSprite->loadSpriteSheet(basePath + "Dude_Monster_Hurt_4.png", 32, 32, 4)) {
-        hurtSprite->setFrameRate(15.0f);  // Increased from 10 to 15 FPS
-        hurtSprite->setLoop(false);
-        m_animations[State::HURT] = hurtSprite;
-    } else {
-        qDebug() << "Failed to load hurt animation";
-        delete hurtSprite;
-    }
-    
-    // Death animation (8 frames)
-    AnimatedSprite* deathSprite = new AnimatedSprite();
-    if (deathSprite->loadSpriteSheet(basePath + "Dude_Monster_Death_8.png", 32, 32, 8)) {
-        deathSprite->setFrameRate(12.0f);  // Increased from 10 to 12 FPS
-        deathSprite->setLoop(false);
-        m_animations[State::DEAD] = deathSprite;
-    } else {
-        qDebug() << "Failed to load death animation";
-        delete deathSprite;
-    }
+    return clips[static_cast<int>(state)];
 }
 
-void Player2D::updateAnimation(float deltaTime) {
-    if (m_animations.contains(m_state)) {
-        m_animations[m_state]->update(deltaTime);
-    }
+const AnimationPlayer* Player2D::getCurrentAnimation() const {
+    const AnimationPlayer& animation = m_store.animation(m_entity);
+    return animation.isLoaded() ? &animation : nullptr;
 }
 
-void Player2D::setPosition(const QPointF& pos) {
-    if (m_position != pos) {
-        m_position = pos;
-        emit positionChanged(m_position);
+bool Player2D::canChangeState() const {
+    if (m_state == State::HURT) {
+        return false;
     }
-}
-
-QRectF Player2D::boundingBox() const {
-    return QRectF(m_position.x(), m_position.y(), WIDTH, HEIGHT);
+    // A throw plays out unless the sheet is missing
+    const AnimationPlayer& animation = m_store.animation(m_entity);
+    return m_state != State::THROWING || !animation.isLoaded() || animation.isFinished();
 }
 
 void Player2D::moveLeft() {
     // Apply acceleration to the left (Mario-like physics)
-    m_velocity.setX(m_velocity.x() - ACCELERATION_X);
-    if (m_velocity.x() < -MAX_SPEED_X) {
-        m_velocity.setX(-MAX_SPEED_X);
+    QPointF& velocity = m_store.velocity(m_entity);
+    velocity.setX(velocity.x() - ACCELERATION_X);
+    if (velocity.x() < -MAX_SPEED_X) {
+        velocity.setX(-MAX_SPEED_X);
     }
-    m_facingRight = false;
-    if (m_state != State::JUMPING && m_state != State::FALLING && m_state != State::HURT) {
+    m_store.setFacingRight(m_entity, false);
+    if (m_state != State::JUMPING && m_state != State::FALLING && canChangeState()) {
         setState(State::RUNNING_LEFT);
     }
 }
 
 void Player2D::moveRight() {
     // Apply acceleration to the right (Mario-like physics)
-    m_velocity.setX(m_velocity.x() + ACCELERATION_X);
-    if (m_velocity.x() > MAX_SPEED_X) {
-        m_velocity.setX(MAX_SPEED_X);
+    QPointF& velocity = m_store.velocity(m_entity);
+    velocity.setX(velocity.x() + ACCELERATION_X);
+    if (velocity.x() > MAX_SPEED_X) {
+        velocity.setX(MAX_SPEED_X);
     }
-    m_facingRight = true;
-    if (m_state != State::JUMPING && m_state != State::FALLING && m_state != State::HURT) {
+    m_store.setFacingRight(m_entity, true);
+    if (m_state != State::JUMPING && m_state != State::FALLING && canChangeState()) {
         setState(State::RUNNING_RIGHT);
     }
 }
 
 void Player2D::jump() {
     // Normal jump when on ground
+    QPointF& velocity = m_store.velocity(m_entity);
     if (m_onGround && m_canJump && m_state != State::HURT) {
-        m_velocity.setY(JUMP_VELOCITY);  // Use JUMP_VELOCITY (negative value for upward)
+        velocity.setY(JUMP_VELOCITY);  // Use JUMP_VELOCITY (negative value for upward)
         m_onGround = false;
         m_canJump = false;  // Prevent infinite jumping
         setState(State::JUMPING);
-        if (m_animations.contains(State::JUMPING)) {
-            m_animations[State::JUMPING]->reset();
-            m_animations[State::JUMPING]->play();
-        }
+        m_store.animation(m_entity).start(clipFor(State::JUMPING));
     }
     // Double jump when in air (if available and off cooldown)
     else if (!m_onGround && m_hasDoubleJump && m_doubleJumpCooldown <= 0.0f && m_state != State::HURT) {
-        m_velocity.setY(JUMP_VELOCITY);  // Same velocity as normal jump
+        velocity.setY(JUMP_VELOCITY);  // Same velocity as normal jump
         m_hasDoubleJump = false;  // Use up the double jump
         m_doubleJumpCooldown = DOUBLE_JUMP_COOLDOWN_TIME;  // Start cooldown
         setState(State::JUMPING);
-        if (m_animations.contains(State::JUMPING)) {
-            m_animations[State::JUMPING]->reset();
-            m_animations[State::JUMPING]->play();
-        }
+        m_store.animation(m_entity).start(clipFor(State::JUMPING));
+        emit doubleJumped();
+    }
+}
+
+bool Player2D::tryThrow() {
+    if (m_state == State::DEAD || m_state == State::HURT || m_throwCooldown > 0.0f) {
+        return false;
     }
+    m_throwCooldown = THROW_COOLDOWN_TIME;
+    m_state = State::THROWING;
+    m_store.animation(m_entity).start(clipFor(State::THROWING));
+    return true;
 }
 
 void Player2D::stopHorizontalMovement() {
     // Apply friction (Mario-like)
-    m_velocity.setX(m_velocity.x() * FRICTION);
-    if (std::abs(m_velocity.x()) < 0.1f) {
-        m_velocity.setX(0);
+    QPointF& velocity = m_store.velocity(m_entity);
+    velocity.setX(velocity.x() * FRICTION);
+    if (std::abs(velocity.x()) < 0.1f) {
+        velocity.setX(0);
     }
-    if (m_onGround && m_state != State::DEAD && m_state != State::HURT && std::abs(m_velocity.x()) < 1.0f) {
+    if (m_onGround && m_state != State::DEAD && canChangeState() && std::abs(velocity.x()) < 1.0f) {
         setState(State::IDLE);
     }
 }
@@ -166,18 +136,13 @@ void Player2D::stopHorizontalMovement() {
 void Player2D::setState(State state) {
     if (m_state != state) {
         m_state = state;
-        // Reset animation when state changes
-        if (m_animations.contains(state)) {
-            m_animations[state]->reset();
-            m_animations[state]->play();
-        }
-        emit stateChanged(state);
+        // Restart animation when state changes
+        m_store.animation(m_entity).start(clipFor(state));
     }
 }
 
 void Player2D::update(float deltaTime) {
-    // Update animation
-    updateAnimation(deltaTime);
+    // Animation is advanced with every other sprite by EntityStore::updateAnimations
     
     // Update double jump cooldown
     if (m_doubleJumpCooldown > 0.0f) {
@@ -187,17 +152,22 @@ void Player2D::update(float deltaTime) {
         }
     }
     
+    if (m_throwCooldown > 0.0f) {
+        m_throwCooldown = std::max(0.0f, m_throwCooldown - deltaTime);
+    }
+    
     if (m_state == State::DEAD) {
         return;
     }
     
     // Update position based on velocity
-    QPointF newPos = m_position + m_velocity * deltaTime;
+    QPointF& velocity = m_store.velocity(m_entity);
+    QPointF newPos = m_store.position(m_entity) + velocity * deltaTime;
     
     // Apply screen boundaries - prevent going off left edge
     if (newPos.x() < 0) {
         newPos.setX(0);
-        m_velocity.setX(0);  // Stop horizontal movement at boundary
+        velocity.setX(0);  // Stop horizontal movement at boundary
     }
     
     setPosition(newPos);
@@ -209,26 +179,26 @@ void Player2D::update(float deltaTime) {
     }
     
     // Cap vertical velocity (Mario-like)
-    if (m_velocity.y() > MAX_SPEED_Y) {
-        m_velocity.setY(MAX_SPEED_Y);
-    } else if (m_velocity.y() < -MAX_SPEED_Y) {
+    if (velocity.y() > MAX_SPEED_Y) {
+        velocity.setY(MAX_SPEED_Y);
+    } else if (velocity.y() < -MAX_SPEED_Y) {
         // Also cap upward velocity to prevent infinite jumping
-        m_velocity.setY(-MAX_SPEED_Y);
+        velocity.setY(-MAX_SPEED_Y);
     }
     
     // Update state based on velocity
-    if (m_state != State::HURT) {
+    if (canChangeState()) {
         if (!m_onGround) {
-            if (m_velocity.y() < 0) {
+            if (velocity.y() < 0) {
                 if (m_state != State::JUMPING) {
                     setState(State::JUMPING);
                 }
-            } else if (m_velocity.y() > 0) {
+            } else if (velocity.y() > 0) {
                 setState(State::FALLING);
             }
         } else {
-            if (std::abs(m_velocity.x()) > 1.0f) {
-                if (m_velocity.x() < 0) {
+            if (std::abs(velocity.x()) > 1.0f) {
+                if (velocity.x() < 0) {
                     setState(State::RUNNING_LEFT);
                 } else {
                     setState(State::RUNNING_RIGHT);
@@ -243,10 +213,11 @@ void Player2D::update(float deltaTime) {
 void Player2D::applyGravity(float deltaTime) {
     if (!m_onGround && m_state != State::DEAD) {
         // Apply gravity (Mario-like - constant acceleration)
-        m_velocity.setY(m_velocity.y() + GRAVITY * deltaTime);
+        QPointF& velocity = m_store.velocity(m_entity);
+        velocity.setY(velocity.y() + GRAVITY * deltaTime);
         // Cap velocity
-        if (m_velocity.y() > MAX_SPEED_Y) {
-            m_velocity.setY(MAX_SPEED_Y);
+        if (velocity.y() > MAX_SPEED_Y) {
+            velocity.setY(MAX_SPEED_Y);
         }
     }
 }
@@ -257,9 +228,10 @@ void Player2D::setOnGround(bool onGround) {
     
     if (onGround && !wasOnGround) {
         // Just landed - reset jump abilities
-        m_velocity.setY(0);
+        m_store.velocity(m_entity).setY(0);
         m_canJump = true;
         m_hasDoubleJump = true;  // Restore double jump when landing
+        emit landed();
     }
 }
 
@@ -279,7 +251,7 @@ void Player2D::heal(int amount) {
 
 void Player2D::die() {
     setState(State::DEAD);
-    m_velocity = QPointF(0, 0);
+    setVelocity(QPointF(0, 0));
     m_lives--;
     emit livesChanged(m_lives);
     emit died();
@@ -288,7 +260,7 @@ void Player2D::die() {
 void Player2D::respawn(const QPointF& spawnPoint) {
     m_spawnPoint = spawnPoint;
     setPosition(spawnPoint);
-    m_velocity = QPointF(0, 0);
+    setVelocity(QPointF(0, 0));
     m_health = 100;
     m_onGround = false;
     setState(State::IDLE);
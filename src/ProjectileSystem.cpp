@@ -0,0 +1,114 @@
+#include "ProjectileSystem.h"
+#include "Level.h"
+#include "SpriteSheet.h"
+#include <cmath>
+
+ProjectileSystem::ProjectileSystem() {
+    // All storage is allocated up front and never grows
+    m_pool.x.resize(CAPACITY);
+    m_pool.y.resize(CAPACITY);
+    m_pool.vx.resize(CAPACITY);
+    m_pool.vy.resize(CAPACITY);
+    m_pool.age.resize(CAPACITY);
+    m_pool.owner.resize(CAPACITY);
+    m_impacts.reserve(CAPACITY);
+}
+
+const SpriteSheet* ProjectileSystem::sheet() {
+    static const SpriteSheet* rock = SpriteSheet::get("assets/sprites/Rock1.png", 8, 8, 1);
+    return rock;
+}
+
+void ProjectileSystem::spawn(Owner owner, const QPointF& position, const QPointF& velocity) {
+    if (m_pool.count == CAPACITY) {
+        return;
+    }
+    
+    int i = m_pool.count++;
+    m_pool.x[i] = static_cast<float>(position.x());
+    m_pool.y[i] = static_cast<float>(position.y());
+    m_pool.vx[i] = static_cast<float>(velocity.x());
+    m_pool.vy[i] = static_cast<float>(velocity.y());
+    m_pool.age[i] = 0.0f;
+    m_pool.owner[i] = static_cast<quint8>(owner);
+}
+
+void ProjectileSystem::remove(int index) {
+    int last = --m_pool.count;
+    m_pool.x[index] = m_pool.x[last];
+    m_pool.y[index] = m_pool.y[last];
+    m_pool.vx[index] = m_pool.vx[last];
+    m_pool.vy[index] = m_pool.vy[last];
+    m_pool.age[index] = m_pool.age[last];
+    m_pool.owner[index] = m_pool.owner[last];
+}
+
+void ProjectileSystem::clear() {
+    m_pool.count = 0;
+    m_impacts.clear();
+}
+
+void ProjectileSystem::update(float deltaTime, const Level& level) {
+    m_impacts.clear();
+    
+    // Restrict-qualified views of the pool: everything below, the
+    // swap-remove included, goes through them and never through m_pool
+    float* __restrict x = m_pool.x.data();
+    float* __restrict y = m_pool.y.data();
+    float* __restrict vx = m_pool.vx.data();
+    float* __restrict vy = m_pool.vy.data();
+    float* __restrict age = m_pool.age.data();
+    quint8* __restrict owner = m_pool.owner.data();
+    int count = m_pool.count;
+    auto retire = [&](int i) {
+        --count;
+        x[i] = x[count];
+        y[i] = y[count];
+        vx[i] = vx[count];
+        vy[i] = vy[count];
+        age[i] = age[count];
+        owner[i] = owner[count];
+    };
+    
+    const float half = SIZE / 2.0f;
+    const float tile = static_cast<float>(Level::TILE_SIZE);
+    // Cells a [min, max] span covers; touching a cell's edge does not count
+    auto firstCell = [tile](float min) { return static_cast<int>(std::floor(min / tile)); };
+    auto lastCell = [tile](float max) { return static_cast<int>(std::ceil(max / tile)) - 1; };
+    float gravityStep = GRAVITY * deltaTime;
+    float levelWidth = static_cast<float>(level.width() * Level::TILE_SIZE);
+    float levelHeight = static_cast<float>(level.height() * Level::TILE_SIZE);
+    
+    for (int i = 0; i < count; ) {
+        vy[i] += gravityStep;
+        age[i] += deltaTime;
+        float nextX = x[i] + vx[i] * deltaTime;
+        float nextY = y[i] + vy[i] * deltaTime;
+        
+        // Most ticks the rock covers the same cells before and after and
+        // skips the sweep entirely: it can only hit a cell it enters
+        bool sameCells = firstCell(x[i] - half) == firstCell(nextX - half) && lastCell(x[i] + half) == lastCell(nextX + half)
+            && firstCell(y[i] - half) == firstCell(nextY - half) && lastCell(y[i] + half) == lastCell(nextY + half);
+        
+        // Sweep the rock's whole box, so a corner clipping a tile hits it
+        TraceHit hit;
+        QRectF box(x[i] - half, y[i] - half, SIZE, SIZE);
+        if (!sameCells && level.sweepBox(box, QPointF(nextX - x[i], nextY - y[i]), &hit)) {
+            // Report the point of the rock's face that touched the tile
+            QPointF centre = hit.position + QPointF(half, half);
+            QPointF contact = centre - QPointF(hit.normal) * half;
+            m_impacts.append({ contact, hit.cell, static_cast<Owner>(owner[i]) });
+            retire(i);
+            continue;
+        }
+        
+        x[i] = nextX;
+        y[i] = nextY;
+        if (age[i] >= LIFETIME || nextX < 0.0f || nextX > levelWidth || nextY > levelHeight) {
+            retire(i);
+            continue;
+        }
+        ++i;
+    }
+    m_pool.count = count;
+}
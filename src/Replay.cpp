@@ -0,0 +1,98 @@
+#include "Replay.h"
+#include <QDebug>
+
+static const char* const HEADER = "# Death Riddle replay v1";
+
+static const char* typeName(ReplayEvent::Type type) {
+    switch (type) {
+        case ReplayEvent::Type::KEY_DOWN: return "down";
+        case ReplayEvent::Type::KEY_REPEAT: return "repeat";
+        case ReplayEvent::Type::KEY_UP: return "up";
+        case ReplayEvent::Type::ANSWER: return "answer";
+        case ReplayEvent::Type::CANCEL: return "cancel";
+        case ReplayEvent::Type::END: return "end";
+    }
+    return "";
+}
+
+Replay::Replay() {
+}
+
+bool Replay::load(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Failed to open replay:" << filePath;
+        return false;
+    }
+    
+    m_events.clear();
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith("#")) continue;
+        
+        // "<tick> <type> [<key> | <answer text>]"
+        QStringList parts = line.split(' ');
+        bool ok = parts.size() >= 2;
+        ReplayEvent event { ok ? parts[0].toInt(&ok) : 0, ReplayEvent::Type::CANCEL, 0, QString() };
+        if (ok) {
+            QString type = parts[1];
+            if (type == "down" || type == "repeat" || type == "up") {
+                event.type = (type == "down") ? ReplayEvent::Type::KEY_DOWN
+                           : (type == "repeat") ? ReplayEvent::Type::KEY_REPEAT
+                           : ReplayEvent::Type::KEY_UP;
+                event.key = parts.value(2).toInt(&ok);
+            } else if (type == "answer") {
+                event.type = ReplayEvent::Type::ANSWER;
+                event.text = line.section(' ', 2);
+            } else if (type == "end") {
+                event.type = ReplayEvent::Type::END;
+            } else if (type != "cancel") {
+                ok = false;
+            }
+        }
+        if (!ok || (!m_events.isEmpty() && event.tick < m_events.last().tick)) {
+            qDebug() << "Bad replay line" << lineNumber << "in" << filePath;
+            return false;
+        }
+        m_events.append(event);
+    }
+    return true;
+}
+
+bool Replay::beginRecording(const QString& filePath) {
+    m_events.clear();
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "Failed to open replay for recording:" << filePath;
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream << HEADER << "\n";
+    m_stream.flush();
+    return true;
+}
+
+void Replay::record(const ReplayEvent& event) {
+    m_events.append(event);
+    if (!isRecording()) return;
+    
+    m_stream << event.tick << ' ' << typeName(event.type);
+    if (event.type == ReplayEvent::Type::ANSWER) {
+        m_stream << ' ' << event.text;
+    } else if (event.type != ReplayEvent::Type::CANCEL && event.type != ReplayEvent::Type::END) {
+        m_stream << ' ' << event.key;
+    }
+    m_stream << "\n";
+    m_stream.flush();
+}
+
+void Replay::endRecording(int tick) {
+    if (!isRecording()) return;
+    
+    record({ tick, ReplayEvent::Type::END, 0, QString() });
+    m_stream.setDevice(nullptr);
+    m_file.close();
+}
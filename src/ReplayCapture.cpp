@@ -0,0 +1,103 @@
+#include "ReplayCapture.h"
+#include "GameWidget.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QThread>
+#include <cstdio>
+
+ReplayCapture::ReplayCapture(Output output, const QString& directory)
+    : m_output(output)
+    , m_directory(directory)
+    , m_slots(QThread::idealThreadCount() * 2)
+    , m_nextFrameToWrite(0)
+    , m_failed(false)
+{
+    m_pool.setObjectName("ReplayCapture");
+}
+
+int ReplayCapture::run(const QVector<ReplayEvent>& events, int maxFrames) {
+    if (m_output == Output::PNG_FILES) {
+        if (!QDir().mkpath(m_directory)) {
+            qDebug() << "Cannot create capture directory:" << m_directory;
+            return -1;
+        }
+    } else if (!m_stdout.open(stdout, QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write frames to stdout";
+        return -1;
+    }
+    
+    GameWidget game;
+    game.startReplay(events);
+    
+    int frames = 0;
+    bool inputLeft = true;
+    while (inputLeft && (maxFrames <= 0 || frames < maxFrames)) {
+        inputLeft = game.stepReplay();
+        
+        // Level swaps and chunk rasterization report back through the event loop
+        QCoreApplication::processEvents();
+        
+        // The scene buffer is reused for the next frame, so the job gets a copy
+        submit(frames++, game.renderScene().copy());
+        writeReadyFrames();
+        
+        QMutexLocker locker(&m_mutex);
+        if (m_failed) break;
+    }
+    
+    m_pool.waitForDone();
+    writeReadyFrames();
+    m_stdout.close();
+    return m_failed ? -1 : frames;
+}
+
+void ReplayCapture::submit(int index, const QImage& frame) {
+    // Wait for a free slot, writing out raw frames meanwhile (they only
+    // release their slot once written, so waiting alone could deadlock)
+    while (!m_slots.tryAcquire(1, 5)) {
+        writeReadyFrames();
+    }
+    
+    if (m_output == Output::PNG_FILES) {
+        QString path = QString("%1/frame_%2.png").arg(m_directory).arg(index, 6, 10, QChar('0'));
+        m_pool.start([this, path, frame]() {
+            if (!frame.save(path, "PNG")) {
+                qDebug() << "Failed to write" << path;
+                QMutexLocker locker(&m_mutex);
+                m_failed = true;
+            }
+            m_slots.release();
+        });
+    } else {
+        m_pool.start([this, index, frame]() {
+            QImage rgba = frame.convertToFormat(QImage::Format_RGBA8888);
+            QByteArray bytes(reinterpret_cast<const char*>(rgba.constBits()), rgba.sizeInBytes());
+            QMutexLocker locker(&m_mutex);
+            m_readyFrames.insert(index, bytes);
+        });
+    }
+}
+
+void ReplayCapture::writeReadyFrames() {
+    if (m_output != Output::RAW_STDOUT) return;
+    
+    while (true) {
+        QByteArray bytes;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_readyFrames.contains(m_nextFrameToWrite)) return;
+            bytes = m_readyFrames.take(m_nextFrameToWrite);
+        }
+        
+        if (m_stdout.write(bytes) != bytes.size()) {
+            // Usually the encoder on the other end of the pipe went away
+            QMutexLocker locker(&m_mutex);
+            m_failed = true;
+        }
+        m_stdout.flush();
+        m_nextFrameToWrite++;
+        m_slots.release();
+    }
+}
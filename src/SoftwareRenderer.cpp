@@ -0,0 +1,58 @@
+#include "SoftwareRenderer.h"
+
+SoftwareRenderer::SoftwareRenderer()
+    : m_kernels(&BlitKernels::select())
+{
+}
+
+void SoftwareRenderer::resize(const QSize& size) {
+    if (m_frame.size() != size) {
+        m_frame = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+}
+
+void SoftwareRenderer::clear(QRgb color) {
+    quint32 value = qPremultiply(color);
+    for (int y = 0; y < m_frame.height(); ++y) {
+        m_kernels->fill(reinterpret_cast<quint32*>(m_frame.scanLine(y)), m_frame.width(), value);
+    }
+}
+
+void SoftwareRenderer::fillRect(const QRect& rect, QRgb color) {
+    QRect target = rect.translated(m_translation).intersected(m_frame.rect());
+    if (target.isEmpty()) return;
+    
+    quint32 value = qPremultiply(color);
+    for (int y = target.top(); y <= target.bottom(); ++y) {
+        quint32* line = reinterpret_cast<quint32*>(m_frame.scanLine(y)) + target.left();
+        m_kernels->fill(line, target.width(), value);
+    }
+}
+
+void SoftwareRenderer::blit(const QImage& source, const QRect& sourceRect, const QPoint& position, bool flipped) {
+    QRect target(position + m_translation, sourceRect.size());
+    QRect clipped = target.intersected(m_frame.rect());
+    if (clipped.isEmpty()) return;
+    
+    // Columns and rows of the target cut off on the left/top
+    int skipX = clipped.left() - target.left();
+    int skipY = clipped.top() - target.top();
+    int count = clipped.width();
+    
+    // When flipped, target column c shows source column (width - 1 - c), so
+    // the visible span starts further right in the source
+    int sourceX = flipped ? sourceRect.left() + sourceRect.width() - skipX - count
+                          : sourceRect.left() + skipX;
+    
+    for (int row = 0; row < clipped.height(); ++row) {
+        const quint32* src = reinterpret_cast<const quint32*>(
+            source.constScanLine(sourceRect.top() + skipY + row)) + sourceX;
+        quint32* dst = reinterpret_cast<quint32*>(m_frame.scanLine(clipped.top() + row)) + clipped.left();
+        
+        if (flipped) {
+            m_kernels->blendFlipped(dst, src, count);
+        } else {
+            m_kernels->blend(dst, src, count);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch()
+    : m_activeBuckets(0)
+    , m_spriteCount(0)
+{
+}
+
+void SpriteBatch::add(const AnimationPlayer& animation, const QPointF& position, bool facingRight) {
+    add(animation.sheet, animation.currentFrame, position, facingRight);
+}
+
+void SpriteBatch::add(const SpriteSheet* sheet, int frame, const QPointF& position, bool facingRight) {
+    const QPixmap* pixmap = facingRight ? &sheet->pixmap() : &sheet->mirroredPixmap();
+    QRect source = facingRight ? sheet->frameRect(frame) : sheet->mirroredFrameRect(frame);
+    
+    // Only a handful of sheets are visible at once, so a linear search wins
+    Bucket* bucket = nullptr;
+    for (int i = 0; i < m_activeBuckets; ++i) {
+        if (m_buckets[i].pixmap == pixmap) {
+            bucket = &m_buckets[i];
+            break;
+        }
+    }
+    if (!bucket) {
+        if (m_activeBuckets == m_buckets.size()) {
+            m_buckets.append(Bucket());
+        }
+        bucket = &m_buckets[m_activeBuckets++];
+        bucket->pixmap = pixmap;
+    }
+    
+    // Fragments are positioned by their centre
+    QPointF centre(position.x() + source.width() / 2.0, position.y() + source.height() / 2.0);
+    bucket->fragments.append(QPainter::PixmapFragment::create(centre, source));
+    m_spriteCount++;
+}
+
+void SpriteBatch::flush(QPainter& painter) {
+    for (int i = 0; i < m_activeBuckets; ++i) {
+        Bucket& bucket = m_buckets[i];
+        painter.drawPixmapFragments(bucket.fragments.constData(),
+                                    static_cast<int>(bucket.fragments.size()), *bucket.pixmap);
+        bucket.fragments.clear();
+    }
+    m_activeBuckets = 0;
+    m_spriteCount = 0;
+}
@@ -0,0 +1,54 @@
+#include "SpriteSheet.h"
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+SpriteSheet::SpriteSheet(const QImage& image, int frameWidth, int frameHeight, int frameCount)
+    : m_image(image)
+    , m_premultiplied(image.convertToFormat(QImage::Format_ARGB32_Premultiplied))
+    , m_frameWidth(frameWidth)
+    , m_frameHeight(frameHeight)
+{
+    m_frames.reserve(frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        m_frames.append(QRect(i * frameWidth, 0, frameWidth, frameHeight));
+    }
+}
+
+const SpriteSheet* SpriteSheet::get(const QString& filePath, int frameWidth, int frameHeight, int frameCount) {
+    static QMutex mutex;
+    static QHash<QString, SpriteSheet*> sheets;
+    
+    QMutexLocker locker(&mutex);
+    auto it = sheets.find(filePath);
+    if (it != sheets.end()) {
+        return it.value();
+    }
+    
+    QImage image(filePath);
+    if (image.isNull()) {
+        qDebug() << "Failed to load sprite sheet:" << filePath;
+        return nullptr;
+    }
+    
+    SpriteSheet* sheet = new SpriteSheet(image, frameWidth, frameHeight, frameCount);
+    sheets.insert(filePath, sheet);
+    return sheet;
+}
+
+const QPixmap& SpriteSheet::pixmap() const {
+    // Pixmaps may only be created on the GUI thread, so the upload is deferred
+    // until the sheet is first drawn
+    if (m_pixmap.isNull()) {
+        m_pixmap = QPixmap::fromImage(m_image);
+    }
+    return m_pixmap;
+}
+
+const QPixmap& SpriteSheet::mirroredPixmap() const {
+    if (m_mirroredPixmap.isNull()) {
+        m_mirroredPixmap = QPixmap::fromImage(m_image.mirrored(true, false));
+    }
+    return m_mirroredPixmap;
+}
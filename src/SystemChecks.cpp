@@ -0,0 +1,314 @@
+#include "SystemChecks.h"
+#include "BehaviourVm.h"
+#include "DynamicAabbTree.h"
+#include "EnemySystem.h"
+#include "EntityStore.h"
+#include "JobSystem.h"
+#include "Level.h"
+#include "LightMap.h"
+#include "ProjectileSystem.h"
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+int SystemChecks::run() {
+    struct Check {
+        const char* name;
+        bool (*run)();
+    };
+    static const Check checks[] = {
+        { "lighting", &SystemChecks::checkLighting },
+        { "aabb tree", &SystemChecks::checkAabbTree },
+        { "far enemies", &SystemChecks::checkFarEnemies },
+    };
+    
+    int failures = 0;
+    for (const Check& check : checks) {
+        bool passed = check.run();
+        qDebug().noquote() << QString("%1: %2").arg(check.name, -12).arg(passed ? "ok" : "FAILED");
+        if (!passed) {
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Light of every tile computed from scratch with the rules LightMap
+// documents: sources light open tiles, light drops by one per step and
+// solid tiles stop it. Relaxes the whole grid until nothing changes.
+static QVector<int> floodLight(const Level& level, const QPoint& playerCell) {
+    int width = level.width();
+    int height = level.height();
+    auto opaque = [&level](int x, int y) { return level.getTileAt(x, y)->type == TileType::SOLID; };
+    
+    QVector<int> light(width * height, 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (opaque(x, y)) continue;
+            int emission = LightMap::emissionOf(*level.getTileAt(x, y));
+            if (QPoint(x, y) == playerCell) {
+                emission = std::max(emission, static_cast<int>(LightMap::PLAYER_LIGHT));
+            }
+            light[y * width + x] = emission;
+        }
+    }
+    
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (opaque(x, y)) continue;
+                int& here = light[y * width + x];
+                auto pull = [&](int nx, int ny) {
+                    if (nx < 0 || nx >= width || ny < 0 || ny >= height) return;
+                    if (light[ny * width + nx] - 1 > here) {
+                        here = light[ny * width + nx] - 1;
+                        changed = true;
+                    }
+                };
+                pull(x - 1, y);
+                pull(x + 1, y);
+                pull(x, y - 1);
+                pull(x, y + 1);
+            }
+        }
+    }
+    return light;
+}
+
+bool SystemChecks::checkLighting() {
+    Level level(5);
+    if (!level.isDark()) {
+        qDebug() << "Lighting check needs level 5 to be dark";
+        return false;
+    }
+    
+    LightMap lightMap;
+    lightMap.reset(&level);
+    QPoint playerCell(level.width() / 2, level.height() / 2);
+    lightMap.setPlayerCell(playerCell);
+    
+    // Fixed seed: a failure reproduces on every run
+    QRandomGenerator random(37);
+    static const TileType placed[] = {
+        TileType::EMPTY, TileType::SOLID, TileType::SOLID, TileType::TORCH,
+        TileType::COIN, TileType::KEY, TileType::CHECKPOINT, TileType::GOAL
+    };
+    const int width = level.width();
+    const int height = level.height();
+    
+    for (int step = 0; step < 2000; ++step) {
+        int x = random.bounded(width);
+        int y = random.bounded(height);
+        QString edit;
+        switch (random.bounded(4)) {
+            case 0: {
+                TileType type = placed[random.bounded(static_cast<int>(std::size(placed)))];
+                level.setTile(x, y, type);
+                lightMap.tileChanged(x, y);
+                edit = QString("set tile (%1, %2) to type %3").arg(x).arg(y).arg(static_cast<int>(type));
+                break;
+            }
+            case 1: {
+                Tile* tile = level.getTileAt(x, y);
+                tile->collected = !tile->collected;
+                tile->activated = !tile->activated;
+                lightMap.tileChanged(x, y);
+                edit = QString("toggled the state of tile (%1, %2)").arg(x).arg(y);
+                break;
+            }
+            case 2:
+                // Walking: one cell at a time, like the player does
+                playerCell += QPoint(random.bounded(-1, 2), random.bounded(-1, 2));
+                playerCell.setX(qBound(0, playerCell.x(), width - 1));
+                playerCell.setY(qBound(0, playerCell.y(), height - 1));
+                lightMap.setPlayerCell(playerCell);
+                edit = QString("moved the player to (%1, %2)").arg(playerCell.x()).arg(playerCell.y());
+                break;
+            default:
+                // Respawning or teleporting: a jump anywhere
+                playerCell = QPoint(x, y);
+                lightMap.setPlayerCell(playerCell);
+                edit = QString("moved the player to (%1, %2)").arg(x).arg(y);
+                break;
+        }
+        
+        QVector<int> expected = floodLight(level, playerCell);
+        for (int cy = 0; cy < height; ++cy) {
+            for (int cx = 0; cx < width; ++cx) {
+                int light = expected[cy * width + cx];
+                int shade = light;
+                if (level.getTileAt(cx, cy)->type == TileType::SOLID) {
+                    // Walls take the brightest neighbour, one step dimmer
+                    shade = 0;
+                    if (cx > 0) shade = std::max(shade, expected[cy * width + cx - 1] - 1);
+                    if (cx < width - 1) shade = std::max(shade, expected[cy * width + cx + 1] - 1);
+                    if (cy > 0) shade = std::max(shade, expected[(cy - 1) * width + cx] - 1);
+                    if (cy < height - 1) shade = std::max(shade, expected[(cy + 1) * width + cx] - 1);
+                }
+                
+                if (lightMap.lightAt(cx, cy) != light || lightMap.shadeAt(cx, cy) != shade) {
+                    qDebug().noquote() << QString("After step %1 (%2): tile (%3, %4) has light %5 shade %6, expected %7 and %8")
+                        .arg(step).arg(edit).arg(cx).arg(cy)
+                        .arg(lightMap.lightAt(cx, cy)).arg(lightMap.shadeAt(cx, cy))
+                        .arg(light).arg(shade);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool SystemChecks::checkAabbTree() {
+    struct Proxy {
+        int id;
+        QRectF box;      // Exact box, the tree only holds its fat box
+    };
+    QVector<Proxy> live;
+    DynamicAabbTree tree;
+    
+    // Same overlap rule as the tree: touching edges count
+    auto overlaps = [](const QRectF& a, const QRectF& b) {
+        return a.left() <= b.right() && b.left() <= a.right()
+            && a.top() <= b.bottom() && b.top() <= a.bottom();
+    };
+    
+    QRandomGenerator random(41);
+    auto randomBox = [&random]() {
+        return QRectF(random.bounded(2000), random.bounded(1000), 8 + random.bounded(40), 8 + random.bounded(40));
+    };
+    
+    for (int step = 0; step < 5000; ++step) {
+        int action = random.bounded(10);
+        if (live.size() < 2 || (action < 3 && live.size() < 256)) {
+            QRectF box = randomBox();
+            live.append({ tree.createProxy(box, step), box });
+        } else if (action < 5) {
+            int i = random.bounded(static_cast<int>(live.size()));
+            tree.destroyProxy(live[i].id);
+            live[i] = live.last();
+            live.removeLast();
+        } else {
+            // Mostly small steps that stay in the fat box, sometimes a teleport
+            Proxy& proxy = live[random.bounded(static_cast<int>(live.size()))];
+            QPointF displacement = action < 9
+                ? QPointF(random.bounded(-6, 7), random.bounded(-6, 7))
+                : QPointF(random.bounded(-500, 501), random.bounded(-500, 501));
+            proxy.box.translate(displacement);
+            tree.moveProxy(proxy.id, proxy.box, displacement);
+        }
+        
+        for (const Proxy& proxy : live) {
+            if (!tree.fatBox(proxy.id).contains(proxy.box)) {
+                qDebug() << "After step" << step << "proxy" << proxy.id << "box" << proxy.box
+                         << "is outside its fat box" << tree.fatBox(proxy.id);
+                return false;
+            }
+        }
+        
+        for (int q = 0; q < 4; ++q) {
+            QRectF area = QRectF(random.bounded(2000), random.bounded(1000), random.bounded(400), random.bounded(400));
+            QVector<int> found;
+            tree.query(area, [&found](int proxy) { found.append(proxy); });
+            
+            QVector<int> expected;
+            for (const Proxy& proxy : live) {
+                if (overlaps(tree.fatBox(proxy.id), area)) {
+                    expected.append(proxy.id);
+                }
+            }
+            std::sort(found.begin(), found.end());
+            std::sort(expected.begin(), expected.end());
+            if (found != expected) {
+                qDebug() << "After step" << step << "query" << area << "found" << found.size()
+                         << "proxies, a linear scan finds" << expected.size();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SystemChecks::checkFarEnemies() {
+    // Every level fits on one screen, so the level of detail is forced with
+    // a viewport placed beside the level. An empty room with a flat floor
+    // keeps the walk free of walls, ledges and turns.
+    Level level(1);
+    for (int y = 0; y < level.height(); ++y) {
+        for (int x = 0; x < level.width(); ++x) {
+            level.setTile(x, y, y == level.height() - 1 ? TileType::SOLID : TileType::EMPTY);
+        }
+    }
+    const qreal levelWidth = level.width() * Level::TILE_SIZE;
+    const QPointF start(levelWidth - 100, (level.height() - 1) * Level::TILE_SIZE - EnemySystem::HEIGHT);
+    const QRectF onScreen(0, 0, levelWidth, level.height() * Level::TILE_SIZE);
+    const QRectF reduced = onScreen.translated(levelWidth + 300, 0);   // About 500 px past the enemy
+    const QRectF asleep = onScreen.translated(levelWidth + 2000, 0);
+    
+    BehaviourVm behaviours;
+    int program = behaviours.load(QStringLiteral("    throw\n    patrol\n"));
+    JobSystem jobs;
+    
+    struct Outcome {
+        qreal x;
+        int throws;
+        bool wentDormant;
+    };
+    
+    // First 2 s at the reduced rate, then asleep for long enough to owe a
+    // full catch-up, then reduced again: the throw falls early in the
+    // catch-up and the rest of it must still be walked
+    auto simulate = [&](bool far) -> Outcome {
+        EntityStore store;
+        EnemySystem enemies;
+        ProjectileSystem projectiles;
+        Entity enemy = EnemySystem::spawn(store, EnemyType::OWLET_MONSTER, start, -1, program);
+        store.enemy(enemy).patrolDistance = 100000.0f;   // Never turns
+        
+        bool wentDormant = false;
+        const float deltaTime = 1.0f / 60.0f;
+        for (int tick = 0; tick < 360; ++tick) {
+            QRectF viewport = onScreen;
+            if (far) {
+                viewport = (tick >= 120 && tick < 236) ? asleep : reduced;
+            }
+            // The player stands to the left, the way the enemy walks, so
+            // turning to throw does not turn it around
+            enemies.update(store, behaviours, { level, QPointF(0, start.y()), deltaTime, viewport, tick },
+                           projectiles, jobs);
+            store.updateAnimations(deltaTime, jobs);
+            wentDormant = wentDormant || store.has(enemy, EntityStore::DORMANT);
+            
+            if (!store.animation(enemy).isLoaded()) {
+                qDebug() << "Far enemy check needs the sprite sheets (run from the source directory)";
+                return { 0, -1, false };
+            }
+        }
+        return { store.position(enemy).x(), projectiles.pool().count, wentDormant };
+    };
+    
+    Outcome near = simulate(false);
+    Outcome far = simulate(true);
+    if (near.throws < 0 || far.throws < 0) {
+        return false;
+    }
+    if (near.wentDormant || !far.wentDormant) {
+        qDebug() << "Far enemy check did not reach the intended levels of detail";
+        return false;
+    }
+    
+    // Reduced-rate steps shift a throw or the end of its clip by at most a
+    // step each; lost time after a throw would cost over a second of walking
+    const qreal tolerance = 4 * EnemySystem::MAX_STEP * EnemySystem::PATROL_SPEED;
+    if (far.throws != near.throws || std::abs(far.x - near.x) > tolerance) {
+        qDebug().noquote() << QString("Far enemy ended at x %1 after %2 throws, every-tick enemy at x %3 after %4")
+            .arg(far.x, 0, 'f', 1).arg(far.throws).arg(near.x, 0, 'f', 1).arg(near.throws);
+        return false;
+    }
+    return true;
+}
@@ -1,7 +1,68 @@
 #include "MainWindow.h"
+#include "Replay.h"
+#include "ReplayCapture.h"
+#include "GoldenFrames.h"
+#include "SystemChecks.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <cstring>
+
+// Headless replay capture:
+//   DeathRiddle --replay run.replay --png frames/
+//   DeathRiddle --replay run.replay --raw | ffmpeg -f rawvideo -pix_fmt rgba -s 960x640 -r 60 -i - out.mp4
+static int runCapture(const QCommandLineParser& parser) {
+    Replay replay;
+    if (!replay.load(parser.value("replay"))) {
+        return 1;
+    }
+    
+    if (parser.isSet("png") == parser.isSet("raw")) {
+        qDebug() << "Pass exactly one of --png <directory> or --raw";
+        return 1;
+    }
+    
+    ReplayCapture capture(parser.isSet("raw") ? ReplayCapture::Output::RAW_STDOUT : ReplayCapture::Output::PNG_FILES,
+                          parser.value("png"));
+    int frames = capture.run(replay.events(), parser.value("frames").toInt());
+    if (frames < 0) {
+        return 1;
+    }
+    qDebug() << "Captured" << frames << "frames";
+    return 0;
+}
+
+// Rendering regression check against stored golden frames:
+//   DeathRiddle --golden-update golden/   (after an intended visual change)
+//   DeathRiddle --golden-check golden/    (exit code 1 on any mismatch, 77 if no golden frames exist)
+//   DeathRiddle --golden-check golden/ --budget-check   (paint budgets fail the check too)
+static int runGoldenFrames(const QCommandLineParser& parser) {
+    // ctest counts this exit code as skipped (SKIP_RETURN_CODE in CMakeLists.txt)
+    static const int SKIPPED_EXIT_CODE = 77;
+    
+    bool update = parser.isSet("golden-update");
+    double budgetScale = parser.isSet("budget-scale") ? parser.value("budget-scale").toDouble() : 1.0;
+    GoldenFrames golden(update ? GoldenFrames::Mode::UPDATE : GoldenFrames::Mode::CHECK,
+                        parser.value(update ? "golden-update" : "golden-check"),
+                        parser.isSet("budget-check"), budgetScale);
+    if (golden.run() != 0) {
+        return 1;
+    }
+    return golden.missingCount() > 0 ? SKIPPED_EXIT_CODE : 0;
+}
 
 int main(int argc, char *argv[]) {
+    // Capture and checks never open a window, so they must not need a display either
+    for (int i = 1; i < argc; ++i) {
+        bool headless = std::strcmp(argv[i], "--replay") == 0
+            || std::strcmp(argv[i], "--golden-check") == 0
+            || std::strcmp(argv[i], "--golden-update") == 0
+            || std::strcmp(argv[i], "--system-check") == 0;
+        if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+    
     QApplication app(argc, argv);
     
     // Set application metadata
@@ -9,6 +70,29 @@ int main(int argc, char *argv[]) {
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("Death Riddle Studios");
     
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({ "replay", "Render a recorded run offscreen instead of playing.", "file" });
+    parser.addOption({ "png", "Write captured frames as numbered PNG files.", "directory" });
+    parser.addOption({ "raw", "Write captured frames as raw 960x640 RGBA to stdout." });
+    parser.addOption({ "frames", "Stop after this many frames.", "count" });
+    parser.addOption({ "golden-check", "Compare every level against the golden frames in a directory.", "directory" });
+    parser.addOption({ "golden-update", "Rewrite the golden frames in a directory.", "directory" });
+    parser.addOption({ "budget-check", "Fail golden frames that blow their paint-time budgets." });
+    parser.addOption({ "budget-scale", "Multiply the paint-time budgets.", "factor" });
+    parser.addOption({ "system-check", "Check the incremental game systems against full recomputation." });
+    parser.process(app);
+    
+    if (parser.isSet("replay")) {
+        return runCapture(parser);
+    }
+    if (parser.isSet("golden-check") || parser.isSet("golden-update")) {
+        return runGoldenFrames(parser);
+    }
+    if (parser.isSet("system-check")) {
+        return SystemChecks::run() == 0 ? 0 : 1;
+    }
+    
     // Create and show main window
     MainWindow window;
     window.show();